@@ -3,11 +3,15 @@ CC = c99
 # Default flags.
 #
 # XOPEN_SOURCE=500 needed to use `sigaction`
-CFLAGS = -D_XOPEN_SOURCE=500 -O2 -pedantic -Wall -Werror -Wextra \
+CFLAGS = -D_XOPEN_SOURCE=500 -O2 -pedantic -pthread -Wall -Werror -Wextra \
 	-Wno-implicit-fallthrough
 
 # OpenBSD flags. Uncomment to use
-# CFLAGS = -O2 -pedantic -Wall -Werror -Wextra
+# CFLAGS = -O2 -pedantic -pthread -Wall -Werror -Wextra
+
+# Debug flags. Uncomment to abort on unchecked access out of bounds
+# CFLAGS = -D_XOPEN_SOURCE=500 -g -pedantic -pthread -Wall -Werror -Wextra \
+# 	-Wno-implicit-fallthrough -DTVEC_CHECK
 
 NAME = se
 PREFIX = /usr/local
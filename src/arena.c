@@ -0,0 +1,76 @@
+#include <stdlib.h>
+#include "arena.h"
+#include "math.h"
+
+enum {
+	ARENA_CHUNK_SIZE = 64 * 1024, /* Default size of arena's chunk. */
+};
+
+/*
+ * Chunk of arena's memory. Chunks are linked from the newest to the oldest.
+ */
+struct chunk {
+	struct chunk *next; /* Previous allocated chunk or `NULL`. */
+	size_t len; /* Length of taken memory. */
+	size_t cap; /* Capacity of the chunk's memory. */
+	char data[]; /* Memory of the chunk. */
+};
+
+/*
+ * Arena of characters.
+ */
+struct arena {
+	struct chunk *head; /* Current chunk or `NULL` if there is no chunks. */
+};
+
+struct arena*
+arena_alloc(void)
+{
+	struct arena *arena;
+
+	/* Allocate opaque struct without chunks. */
+	arena = malloc(sizeof(*arena));
+	if (NULL == arena)
+		return NULL;
+	arena->head = NULL;
+	return arena;
+}
+
+void
+arena_free(struct arena *const arena)
+{
+	struct chunk *next;
+
+	/* Free chunks. */
+	while (NULL != arena->head) {
+		next = arena->head->next;
+		free(arena->head);
+		arena->head = next;
+	}
+	free(arena);
+}
+
+char*
+arena_get(struct arena *const arena, const size_t size)
+{
+	size_t cap;
+	struct chunk *chunk = arena->head;
+
+	/* Allocate new chunk if there is no space in the current one. */
+	if (NULL == chunk || chunk->cap - chunk->len < size) {
+		/* Big requests get their own chunk. */
+		cap = MAX(size, (size_t)ARENA_CHUNK_SIZE);
+		chunk = malloc(sizeof(*chunk) + cap);
+		if (NULL == chunk)
+			return NULL;
+		chunk->len = 0;
+		chunk->cap = cap;
+
+		/* Make the chunk current. */
+		chunk->next = arena->head;
+		arena->head = chunk;
+	}
+
+	chunk->len += size;
+	return &chunk->data[chunk->len - size];
+}
@@ -0,0 +1,32 @@
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <stddef.h>
+
+/*
+ * Opaque arena of characters. Memory is taken from big chunks and is never
+ * freed separately. The whole arena is freed at once.
+ */
+struct arena;
+
+/*
+ * Allocates empty arena. Do not forget to free it.
+ *
+ * Returns pointer to opaque arena on success and `NULL` on error.
+ */
+struct arena *arena_alloc(void);
+
+/*
+ * Frees allocated arena with all memory taken from it.
+ */
+void arena_free(struct arena *);
+
+/*
+ * Takes memory of passed size from the arena. Memory is not aligned, so use
+ * it only for characters.
+ *
+ * Returns pointer to memory on success and `NULL` on error.
+ */
+char *arena_get(struct arena *, size_t);
+
+#endif /* _ARENA_H */
@@ -0,0 +1,49 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include "buf.h"
+
+int
+buf_append_fmt(struct buf *const buf, const char *const fmt, ...)
+{
+	int len;
+	int ret;
+	va_list args;
+	char str[256];
+
+	/* Format arguments. */
+	va_start(args, fmt);
+	len = vsnprintf(str, sizeof(str), fmt, args);
+	va_end(args);
+	if (len < 0 || (size_t)len >= sizeof(str))
+		return -1;
+
+	/* Append formatted string to the buffer. */
+	ret = buf_append(buf, str, len);
+	if (-1 == ret)
+		return -1;
+	return len;
+}
+
+int
+buf_append_ref(
+	struct buf *const buf,
+	struct buf_refs *const refs,
+	const char *const chars,
+	const size_t len)
+{
+	int ret;
+	struct buf_ref ref;
+
+	/* Copy short characters. */
+	if (len < BUF_REF_MIN_LEN) {
+		ret = buf_append(buf, chars, len);
+		return ret;
+	}
+
+	/* Refer to characters at the current end of the buffer. */
+	ref.off = buf->len;
+	ref.chars = chars;
+	ref.len = len;
+	ret = buf_refs_append(refs, &ref, 1);
+	return ret;
+}
@@ -0,0 +1,46 @@
+#ifndef _BUF_H
+#define _BUF_H
+
+#include "tvec.h"
+
+/*
+ * Typed vector of characters. Collects content before writing it at once.
+ */
+TVEC_DEF(buf, char)
+
+enum {
+	BUF_REF_MIN_LEN = 64, /* Shorter characters are copied instead. */
+};
+
+/*
+ * Characters, which are written with the buffer without copying to it. They
+ * are written between the buffer's characters before and after the offset.
+ */
+struct buf_ref {
+	size_t off; /* Offset in the buffer where characters are written. */
+	const char *chars; /* Referenced characters. */
+	size_t len; /* Length of referenced characters. */
+};
+
+/*
+ * Typed vector of references in order of their offsets.
+ */
+TVEC_DEF(buf_refs, struct buf_ref)
+
+/*
+ * Appends formatted string to the buffer.
+ *
+ * Returns formatted length on success and -1 on error.
+ */
+int buf_append_fmt(struct buf *, const char *, ...);
+
+/*
+ * Appends passed characters to the buffer by reference, so they must be valid
+ * until the buffer is written. Short characters are copied because reference
+ * costs more.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int buf_append_ref(struct buf *, struct buf_refs *, const char *, size_t);
+
+#endif /* _BUF_H */
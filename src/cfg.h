@@ -15,8 +15,13 @@ enum {
  */
 enum {
 	CFG_DIRTY_FILE_QUIT_PRESSES_CNT = 4, /* Press to exit without saving. */
+	CFG_ESC_TIMEOUT_MS = 50, /* Wait for the rest of escape sequence. */
+	CFG_FRAME_INTERVAL_MS = 16, /* Min frames interval if input is pending. */
+	CFG_LOADING_REDRAW_MS = 100, /* Redraw period during file loading. */
 	CFG_SPARE_PATH_MAX_LEN = 255, /* Max length of formatted spare save path. */
 	CFG_TAB_SIZE = 8, /* Count of spaces, which equals to one tab. */
+	CFG_THREADS_CNT = 4, /* Threads for heavy operations. Also see `-t`. */
+	CFG_THREADS_MAX = 256, /* Max count of threads, which is set by `-t`. */
 };
 
 /*
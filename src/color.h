@@ -1,18 +1,41 @@
 #ifndef _COLOR_H
 #define _COLOR_H
 
+#include <stddef.h>
+
 /*
- * RGB color.
+ * RGB color with escape sequences to begin colored output, which are built in
+ * compile time, so drawing does not format them.
  */
 struct color {
 	unsigned char r;
 	unsigned char g;
 	unsigned char b;
+	const char *fg; /* Escape sequence of colored foreground. */
+	size_t fg_len; /* Length of foreground's escape sequence. */
+	const char *bg; /* Escape sequence of colored background. */
+	size_t bg_len; /* Length of background's escape sequence. */
 };
 
 /*
- * Macro to create new color in compile time.
+ * Macro to create escape sequence of the color for passed layer. 38 is the
+ * foreground and 48 is the background.
+ */
+#define COLOR_SEQ(layer, red, green, blue) \
+	"\x1b[" #layer ";2;" #red ";" #green ";" #blue "m"
+
+/*
+ * Macro to create new color in compile time. Components must be decimal
+ * literals because they are also put to escape sequences as is.
  */
-#define COLOR_NEW(red, green, blue) { .r = (red), .g = (green), .b = (blue) }
+#define COLOR_NEW(red, green, blue) { \
+	.r = (red), \
+	.g = (green), \
+	.b = (blue), \
+	.fg = COLOR_SEQ(38, red, green, blue), \
+	.fg_len = sizeof(COLOR_SEQ(38, red, green, blue)) - 1, \
+	.bg = COLOR_SEQ(48, red, green, blue), \
+	.bg_len = sizeof(COLOR_SEQ(48, red, green, blue)) - 1, \
+}
 
 #endif /* _COLOR_H */
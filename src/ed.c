@@ -6,27 +6,49 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
+#include "buf.h"
 #include "cfg.h"
 #include "ed.h"
 #include "esc.h"
+#include "input.h"
 #include "math.h"
 #include "mode.h"
 #include "path.h"
+#include "scr.h"
+#include "search.h"
 #include "term.h"
-#include "vec.h"
+#include "tvec.h"
 #include "win.h"
 
+enum {
+	ED_BUF_CAP = 4096, /* Initial capacity of the drawing buffer. */
+};
+
+/*
+ * Typed vector of parts of the content written at once.
+ */
+TVEC_DEF(iovs, struct iovec)
+
 /*
  * Editor options.
  */
 struct ed {
-	struct vec *buf; /* Buffer for all drawn content. */
+	struct buf buf; /* Buffer for all drawn content. */
+	struct buf_refs refs; /* Drawn content, which is not copied to the buffer. */
+	struct iovs iovs; /* Parts of the buffer and references to write. */
+	struct scr *scr; /* Shadow screen with the previous frame. */
+	struct input *input; /* Read input, which is not processed yet. */
+	struct buf paste; /* Pasted content, which is not inserted yet. */
+	char is_pasting; /* If set, then keys are collected as pasted content. */
+	char is_sync_upd; /* If set, then terminal supports synchronized updates. */
 	struct win *win; /* Info about terminal's view. This is what the user sees. */
 	enum mode mode; /* Input mode. */
 	char msg[64]; /* Message for the user. */
 	size_t num_input; /* Number input. 0 if not set. */
 	char search_input[64]; /* Search input. */
 	size_t search_input_len; /* Search query input length. */
+	struct search search; /* Prepared search of the last query. */
 	unsigned char quit_presses_rem; /* Greater than 1 if file is dirty. */
 	volatile sig_atomic_t sigwinch; /* Resize flag. See signal-safety(7). */
 };
@@ -60,7 +82,7 @@ static int ed_del_line(struct ed *);
 static int ed_draw_end(struct ed *);
 
 /*
- * Starts drawing area. For example, hides the cursor and clears the screen.
+ * Starts drawing area. For example, hides the cursor and resizes the screen.
  *
  * Returns 0 on success and -1 on error.
  */
@@ -78,14 +100,7 @@ static int ed_draw_stat(struct ed *);
  *
  * Returns 0 on success and -1 on error.
  */
-static int ed_draw_stat_begin(struct ed *);
-
-/*
- * Ends for status drawing.
- *
- * Returns 0 on success and -1 on error.
- */
-static int ed_draw_stat_end(struct ed *);
+static int ed_draw_stat_begin(struct scr_row *);
 
 /*
  * Formats the right part of the status to the passed buffer up to passed
@@ -100,14 +115,15 @@ static int ed_draw_stat_fmt_right(const struct ed *, char *, size_t);
  *
  * Returns length on success and -1 on error.
  */
-static int ed_draw_stat_left(struct ed *);
+static int ed_draw_stat_left(struct ed *, struct scr_row *);
 
 /*
  * Draws an empty space between left and right parts.
  *
  * Returns 0 on success and -1 on error.
  */
-static int ed_draw_stat_space(struct ed *, size_t, size_t);
+static int ed_draw_stat_space(
+	struct ed *, struct scr_row *, size_t, size_t);
 
 /*
  * Flush editor's drawing buffer.
@@ -137,6 +153,14 @@ static int ed_ins_empty_line_below(struct ed *);
  */
 static int ed_ins_empty_line_on_top(struct ed *);
 
+/*
+ * Inserts collected pasted content at once and clears it. Content is inserted
+ * only in insertion mode.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+static int ed_ins_paste(struct ed *);
+
 /*
  * Clears the message.
  */
@@ -175,6 +199,13 @@ static void ed_num_input_clr(struct ed *);
  */
 static int ed_on_quit_press(struct ed *);
 
+/*
+ * Collects key of the pasted content. Inserts the content when paste ends.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+static int ed_paste(struct ed *, const char *, size_t);
+
 /*
  * Processes arrow key.
  *
@@ -182,6 +213,13 @@ static int ed_on_quit_press(struct ed *);
  */
 static int ed_proc_arrow_key(struct ed *, const char *, size_t);
 
+/*
+ * Processes begin key of bracketed paste.
+ *
+ * Returns 0 on success or invalid key and -1 on error.
+ */
+static int ed_proc_brkt_paste_key(struct ed *, const char *, size_t);
+
 /*
  * Process key in insertion mode.
  *
@@ -189,6 +227,14 @@ static int ed_proc_arrow_key(struct ed *, const char *, size_t);
  */
 static int ed_proc_ins_key(struct ed *, char);
 
+/*
+ * Processes key in current mode. Key of several characters is an escape
+ * sequence.
+ *
+ * Returns 0 on success or invalid key and -1 on error.
+ */
+static int ed_proc_key(struct ed *, const char *, size_t);
+
 /*
  * Processes mouse wheel key.
  *
@@ -224,6 +270,13 @@ static int ed_proc_seq_key(struct ed *, const char *, size_t);
  */
 static int ed_proc_sig(struct ed *);
 
+/*
+ * Processes the terminal's report about synchronized updates support.
+ *
+ * Returns 0 on success or invalid key and -1 on error.
+ */
+static int ed_proc_sync_upd_report(struct ed *, const char *, size_t);
+
 /*
  * Determines how many times the next action needs to be repeated.
  */
@@ -328,17 +381,27 @@ ed_draw(struct ed *const ed)
 	if (-1 == ret)
 		return -1;
 
+	/* Take lines loaded in background. */
+	ret = win_take_loaded_lines(ed->win);
+	if (-1 == ret)
+		return -1;
+
 	/* Draw all content. */
 	ret = ed_draw_start(ed);
 	if (-1 == ret)
 		return -1;
-	ret = win_draw_lines(ed->win, ed->buf);
+	ret = win_draw_lines(ed->win, ed->scr);
 	if (-1 == ret)
 		return -1;
 	ret = ed_draw_stat(ed);
 	if (-1 == ret)
 		return -1;
-	ret = win_draw_cur(ed->win, ed->buf);
+
+	/* Update only changed parts of the screen. */
+	ret = scr_flush(ed->scr, &ed->buf, &ed->refs);
+	if (-1 == ret)
+		return -1;
+	ret = win_draw_cur(ed->win, &ed->buf);
 	if (-1 == ret)
 		return -1;
 	ret = ed_draw_end(ed);
@@ -356,7 +419,13 @@ ed_draw_end(struct ed *const ed)
 	int ret;
 
 	/* Show hidden cursor. */
-	ret = esc_cur_show(ed->buf);
+	ret = esc_cur_show(&ed->buf);
+	if (-1 == ret)
+		return -1;
+
+	/* Let the terminal show the whole frame. */
+	if (ed->is_sync_upd)
+		ret = esc_sync_upd_end(&ed->buf);
 	return ret;
 }
 
@@ -364,19 +433,23 @@ static int
 ed_draw_start(struct ed *const ed)
 {
 	int ret;
+	struct winsize winsize;
 
-	/* Go to start of window and clear the window. */
-	ret = esc_go_home(ed->buf);
+	/* The screen is cleared in the next frame if its size is changed. */
+	winsize = win_size(ed->win);
+	ret = scr_resize(ed->scr, winsize.ws_row, winsize.ws_col);
 	if (-1 == ret)
 		return -1;
 
-	/* Clears all window for new content. */
-	ret = esc_clr_win(ed->buf);
-	if (-1 == ret)
-		return -1;
+	/* Ask the terminal to hold the frame until its end not to tear it. */
+	if (ed->is_sync_upd) {
+		ret = esc_sync_upd_begin(&ed->buf);
+		if (-1 == ret)
+			return -1;
+	}
 
 	/* Hide cursor to not flicker. */
-	ret = esc_cur_hide(ed->buf);
+	ret = esc_cur_hide(&ed->buf);
 	return ret;
 }
 
@@ -388,14 +461,21 @@ ed_draw_stat(struct ed *const ed)
 	struct winsize winsize;
 	int right_len;
 	char right[128];
+	struct scr_row *row;
+
+	/* Nowhere to draw status if the window has no rows. */
+	winsize = win_size(ed->win);
+	if (0 == winsize.ws_row)
+		return 0;
 
 	/* Begin status drawing. */
-	ret = ed_draw_stat_begin(ed);
+	row = scr_row(ed->scr, winsize.ws_row - 1);
+	ret = ed_draw_stat_begin(row);
 	if (-1 == ret)
 		return -1;
 
 	/* Draw the left part of the status. */
-	left_len = ed_draw_stat_left(ed);
+	left_len = ed_draw_stat_left(ed, row);
 	if (-1 == left_len)
 		return -1;
 	/* Format the right part to the passed buffer. */
@@ -404,43 +484,28 @@ ed_draw_stat(struct ed *const ed)
 		return -1;
 
 	/* Draw colored empty space. */
-	ret = ed_draw_stat_space(ed, left_len, right_len);
+	ret = ed_draw_stat_space(ed, row, left_len, right_len);
 	if (-1 == ret)
 		return -1;
 
 	/* Draw the right part. */
-	winsize = win_size(ed->win);
-	ret = vec_append(ed->buf, right, MIN(right_len, winsize.ws_col - left_len));
-	if (-1 == ret)
-		return -1;
-
-	/* End status drawing. */
-	ret = ed_draw_stat_end(ed);
+	ret = buf_append(
+		&row->chars, right, MIN(right_len, winsize.ws_col - left_len));
 	return ret;
 }
 
 static int
-ed_draw_stat_begin(struct ed *const ed)
+ed_draw_stat_begin(struct scr_row *const row)
 {
 	int ret;
 
 	/* Begin colored background output. */
-	ret = esc_color_bg(ed->buf, cfg_color_stat_bg);
+	ret = esc_color_bg(&row->attrs, &cfg_color_stat_bg);
 	if (-1 == ret)
 		return -1;
 
 	/* Begin colored foreground output. */
-	ret = esc_color_fg(ed->buf, cfg_color_stat_fg);
-	return ret;
-}
-
-static int
-ed_draw_stat_end(struct ed *const ed)
-{
-	int ret;
-
-	/* End colored output. */
-	ret = esc_color_end(ed->buf);
+	ret = esc_color_fg(&row->attrs, &cfg_color_stat_fg);
 	return ret;
 }
 
@@ -474,7 +539,7 @@ ed_draw_stat_fmt_right(
 }
 
 static int
-ed_draw_stat_left(struct ed *const ed)
+ed_draw_stat_left(struct ed *const ed, struct scr_row *const row)
 {
 	int ret;
 	int len = 0;
@@ -482,23 +547,32 @@ ed_draw_stat_left(struct ed *const ed)
 
 	/* Draw mode and filename. */
 	fname = path_get_fname(win_file_path(ed->win));
-	ret = vec_append_fmt(ed->buf, " %s > %s", mode_str(ed->mode), fname);
+	ret = buf_append_fmt(&row->chars, " %s > %s", mode_str(ed->mode), fname);
 	if (-1 == ret)
 		return -1;
 	len += ret;
 
 	/* Add mark if file is dirty. */
 	if (win_file_is_dirty(ed->win)) {
-		ret = vec_append(ed->buf, " [+]", 4);
+		ret = buf_append(&row->chars, " [+]", 4);
 		if (-1 == ret)
 			return -1;
 		len += 4;
 	}
 
+	/* Add loading progress if file is still loading. */
+	if (win_file_is_loading(ed->win)) {
+		ret = buf_append_fmt(
+			&row->chars, " [loading %zu%%]", win_file_load_pct(ed->win));
+		if (-1 == ret)
+			return -1;
+		len += ret;
+	}
+
 	/* Draw message if set. */
 	if (!ed_msg_is_empty(ed)) {
 		/* Draw message. */
-		ret = vec_append_fmt(ed->buf, ": %s", ed->msg);
+		ret = buf_append_fmt(&row->chars, ": %s", ed->msg);
 		if (-1 == ret)
 			return -1;
 		len += ret;
@@ -511,7 +585,10 @@ ed_draw_stat_left(struct ed *const ed)
 
 static int
 ed_draw_stat_space(
-	struct ed *const ed, const size_t left_len, const size_t right_len)
+	struct ed *const ed,
+	struct scr_row *const row,
+	const size_t left_len,
+	const size_t right_len)
 {
 	int ret;
 	size_t i;
@@ -521,7 +598,7 @@ ed_draw_stat_space(
 	winsize = win_size(ed->win);
 	/* Draw empty space. */
 	for (i = left_len + right_len; i < winsize.ws_col; i++) {
-		ret = vec_append(ed->buf, " ", 1);
+		ret = buf_append(&row->chars, " ", 1);
 		if (-1 == ret)
 			return -1;
 	}
@@ -532,17 +609,58 @@ static int
 ed_flush_buf(struct ed *const ed)
 {
 	int ret;
-	ssize_t len;
+	size_t i;
+	size_t off = 0;
+	size_t end;
+	struct iovec part;
+	const struct buf_ref *ref;
+
+	/* Interleave parts of the buffer with referenced content. */
+	ed->iovs.len = 0;
+	for (i = 0; i <= ed->refs.len; i++) {
+		end = i < ed->refs.len ? buf_refs_at(&ed->refs, i)->off : ed->buf.len;
+		if (end > off) {
+			part.iov_base = &ed->buf.items[off];
+			part.iov_len = end - off;
+			ret = iovs_append(&ed->iovs, &part, 1);
+			if (-1 == ret)
+				return -1;
+			off = end;
+		}
+		if (i < ed->refs.len) {
+			ref = buf_refs_at(&ed->refs, i);
+			part.iov_base = (char *)ref->chars;
+			part.iov_len = ref->len;
+			ret = iovs_append(&ed->iovs, &part, 1);
+			if (-1 == ret)
+				return -1;
+		}
+	}
 
-	/* Write buffer to terminal. */
-	len = term_write(vec_items(ed->buf), vec_len(ed->buf));
-	if (-1 == len)
+	/* Write all parts to terminal at once. */
+	ret = term_writev(ed->iovs.items, ed->iovs.len);
+	if (-1 == ret)
 		return -1;
 
 	/*
 	 * Set the length to zero to continue appending characters to the beginning.
 	 */
-	ret = vec_set_len(ed->buf, 0);
+	ed->buf.len = 0;
+	ed->refs.len = 0;
+	return 0;
+}
+
+int
+ed_has_input(const struct ed *const ed)
+{
+	int ret;
+
+	/* Check read input first to avoid system call. */
+	if (!input_is_empty(ed->input))
+		return 1;
+
+	/* Check input, which is not read yet. */
+	ret = term_wait_input(0);
 	return ret;
 }
 
@@ -617,6 +735,42 @@ ed_ins_empty_line_on_top(struct ed *const ed)
 	return 0;
 }
 
+static int
+ed_ins_paste(struct ed *const ed)
+{
+	int ret = 0;
+	size_t i;
+	size_t len = 0;
+	char *const chars = ed->paste.items;
+
+	/* Pasted content is not a command, so it is dropped in other modes. */
+	if (MODE_INS != ed->mode) {
+		ret = ed_msg_set(ed, "Paste works only in insertion mode.");
+		goto ret_free;
+	}
+
+	/* Terminals send line breaks as `'\r'`, so replace them and CRLF. */
+	for (i = 0; i < ed->paste.len; i++) {
+		if ('\r' == chars[i]) {
+			chars[len++] = '\n';
+			if (i + 1 < ed->paste.len && '\n' == chars[i + 1])
+				i++;
+		} else {
+			chars[len++] = chars[i];
+		}
+	}
+
+	/* Insert the whole content using window. */
+	if (len > 0) {
+		ret = win_ins_str(ed->win, chars, len);
+		ed->quit_presses_rem = CFG_DIRTY_FILE_QUIT_PRESSES_CNT;
+	}
+ret_free:
+	/* Big paste must not hold memory. */
+	buf_free(&ed->paste);
+	return ret;
+}
+
 static void
 ed_msg_clr(struct ed *const ed)
 {
@@ -670,7 +824,11 @@ ed_on_quit_press(struct ed *const ed)
 }
 
 struct ed*
-ed_open(const char *const path, const int ifd, const int ofd)
+ed_open(
+	const char *const path,
+	const int ifd,
+	const int ofd,
+	const size_t threads_cnt)
 {
 	int ret;
 	struct ed *ed;
@@ -681,43 +839,99 @@ ed_open(const char *const path, const int ifd, const int ofd)
 		return NULL;
 
 	/* Allocate buffer for all drawn content. */
-	ed->buf = vec_alloc(sizeof(char), 4096);
-	if (NULL == ed->buf)
+	buf_init(&ed->buf);
+	buf_refs_init(&ed->refs);
+	iovs_init(&ed->iovs);
+	ret = buf_reserve(&ed->buf, ED_BUF_CAP);
+	if (-1 == ret)
 		goto err_free_opaque;
 
+	/* Allocate shadow screen. It will be resized during first drawing. */
+	ed->scr = scr_alloc();
+	if (NULL == ed->scr)
+		goto err_free_opaque_and_buf;
+
+	/* Allocate ring of input. */
+	ed->input = input_alloc();
+	if (NULL == ed->input)
+		goto err_free_opaque_buf_and_scr;
+
 	/* Open window with accepted file and descriptors. */
-	ed->win = win_open(path, ifd, ofd);
+	ed->win = win_open(path, ifd, ofd, threads_cnt);
 	if (NULL == ed->win)
-		goto err_free_opaque_and_buf;
+		goto err_free_opaque_buf_scr_and_input;
 
 	/* Initialize other values */
+	buf_init(&ed->paste);
+	ed->is_pasting = 0;
+	ed->is_sync_upd = 0;
 	ed_switch_mode(ed, MODE_NORM);
 	ed_msg_clr(ed);
 	ed_num_input_clr(ed);
 	ed_search_input_clr(ed);
+	search_init(&ed->search);
 	ed->quit_presses_rem = 1;
 	ed->sigwinch = 0;
 
 	/* Enable alternate screen. It will be set during first drawing. */
-	ret = esc_alt_scr_on(ed->buf);
+	ret = esc_alt_scr_on(&ed->buf);
 	if (-1 == ret)
 		goto err_clean_all;
 
 	/* Enable mouse wheel tracking. It will be set during first drawing. */
-	ret = esc_mouse_wh_track_on(ed->buf);
+	ret = esc_mouse_wh_track_on(&ed->buf);
+	if (-1 == ret)
+		goto err_clean_all;
+
+	/* Enable bracketed paste. It will be set during first drawing. */
+	ret = esc_brkt_paste_on(&ed->buf);
+	if (-1 == ret)
+		goto err_clean_all;
+
+	/*
+	 * Ask about synchronized updates. Frames are drawn as is until the terminal
+	 * reports the support, and other terminals just do not answer.
+	 */
+	ret = esc_sync_upd_query(&ed->buf);
 	if (-1 == ret)
 		goto err_clean_all;
 	return ed;
 err_clean_all:
 	/* Error checking here is useless. */
 	win_close(ed->win);
+err_free_opaque_buf_scr_and_input:
+	input_free(ed->input);
+err_free_opaque_buf_and_scr:
+	scr_free(ed->scr);
 err_free_opaque_and_buf:
-	vec_free(ed->buf);
+	buf_free(&ed->buf);
 err_free_opaque:
 	free(ed);
 	return NULL;
 }
 
+static int
+ed_paste(struct ed *const ed, const char *const key, const size_t len)
+{
+	int ret;
+	enum brkt_paste_key paste_key;
+
+	/* Insert collected content if paste ends. */
+	ret = esc_extr_brkt_paste_key(key, len, &paste_key);
+	if (0 == ret && BRKT_PASTE_KEY_END == paste_key) {
+		ed->is_pasting = 0;
+		ret = ed_ins_paste(ed);
+		return ret;
+	}
+
+	/* Collect only characters, which can be inserted. */
+	if (1 != len || (!isprint(key[0]) && '\t' != key[0] && '\r' != key[0]
+			&& '\n' != key[0]))
+		return 0;
+	ret = buf_append(&ed->paste, key, 1);
+	return ret;
+}
+
 static int
 ed_proc_arrow_key(struct ed *const ed, const char *const seq, const size_t len)
 {
@@ -748,6 +962,24 @@ ed_proc_arrow_key(struct ed *const ed, const char *const seq, const size_t len)
 	return ret;
 }
 
+static int
+ed_proc_brkt_paste_key(
+	struct ed *const ed, const char *const seq, const size_t len)
+{
+	int ret;
+	enum brkt_paste_key key;
+
+	/* Try to extract paste key. End without begin is ignored. */
+	ret = esc_extr_brkt_paste_key(seq, len, &key);
+	if (-1 == ret || BRKT_PASTE_KEY_BEGIN != key)
+		return 0;
+
+	/* Collect next keys until the paste ends. */
+	ed->paste.len = 0;
+	ed->is_pasting = 1;
+	return 0;
+}
+
 static int
 ed_proc_ins_key(struct ed *const ed, const char key)
 {
@@ -770,6 +1002,47 @@ ed_proc_ins_key(struct ed *const ed, const char key)
 	return ret;
 }
 
+static int
+ed_proc_key(struct ed *const ed, const char *const key, const size_t len)
+{
+	int ret = 0;
+
+	/* Pasted keys are not processed until the paste ends. */
+	if (ed->is_pasting) {
+		ret = ed_paste(ed, key, len);
+		return ret;
+	}
+
+	/* Process key sequence if it has more than one character. */
+	if (len > 1) {
+		/*
+		 * When switching to other modes, the number input will be cleared in the
+		 * normal mode key processing function. This is not done here, so we need
+		 * this line.
+		 */
+		ed_num_input_clr(ed);
+
+		ret = ed_proc_seq_key(ed, key, len);
+		return ret;
+	}
+
+	/* Process single character keys in different input modes. */
+	switch (ed->mode) {
+	case MODE_NORM:
+		ret = ed_proc_norm_key(ed, key[0]);
+		break;
+	case MODE_INS:
+		ret = ed_proc_ins_key(ed, key[0]);
+		ed_num_input_clr(ed);
+		break;
+	case MODE_SEARCH:
+		ret = ed_proc_search_key(ed, key[0]);
+		ed_num_input_clr(ed);
+		break;
+	}
+	return ret;
+}
+
 static int
 ed_proc_mouse_wh_key(
 	struct ed *const ed, const char *const seq, const size_t len)
@@ -844,7 +1117,7 @@ ed_proc_norm_key(struct ed *const ed, const char key)
 		win_mv_to_begin_of_line(ed->win);
 		break;
 	case CFG_KEY_MV_TO_END_OF_FILE:
-		win_mv_to_end_of_file(ed->win);
+		ret = win_mv_to_end_of_file(ed->win);
 		break;
 	case CFG_KEY_MV_TO_END_OF_LINE:
 		ret = win_mv_to_end_of_line(ed->win);
@@ -856,10 +1129,14 @@ ed_proc_norm_key(struct ed *const ed, const char key)
 		ret = win_mv_to_prev_word(ed->win, ed_repeat_times(ed));
 		break;
 	case CFG_KEY_SEARCH_BWD:
-		ret = win_search_bwd(ed->win, ed->search_input);
+		ret = search_set(&ed->search, ed->search_input, ed->search_input_len);
+		if (0 == ret)
+			ret = win_search_bwd(ed->win, &ed->search);
 		break;
 	case CFG_KEY_SEARCH_FWD:
-		ret = win_search_fwd(ed->win, ed->search_input);
+		ret = search_set(&ed->search, ed->search_input, ed->search_input_len);
+		if (0 == ret)
+			ret = win_search_fwd(ed->win, &ed->search);
 		break;
 	}
 
@@ -917,6 +1194,16 @@ ed_proc_seq_key(struct ed *const ed, const char *const seq, const size_t len)
 
 	/* Try to process mouse wheel key. */
 	ret = ed_proc_mouse_wh_key(ed, seq, len);
+	if (-1 == ret)
+		return -1;
+
+	/* Try to process begin of bracketed paste. */
+	ret = ed_proc_brkt_paste_key(ed, seq, len);
+	if (-1 == ret)
+		return -1;
+
+	/* Try to process report about synchronized updates. */
+	ret = ed_proc_sync_upd_report(ed, seq, len);
 	return ret;
 }
 
@@ -937,18 +1224,39 @@ ed_proc_sig(struct ed *const ed)
 	return 0;
 }
 
+static int
+ed_proc_sync_upd_report(
+	struct ed *const ed, const char *const seq, const size_t len)
+{
+	int ret;
+	char is_supported;
+
+	/* Try to extract the report. */
+	ret = esc_extr_sync_upd_report(seq, len, &is_supported);
+	if (-1 == ret)
+		return 0;
+
+	ed->is_sync_upd = is_supported;
+	return 0;
+}
+
 int
 ed_quit(struct ed *const ed)
 {
 	int ret;
 
 	/* Disable alternate screen. */
-	ret = esc_alt_scr_off(ed->buf);
+	ret = esc_alt_scr_off(&ed->buf);
 	if (-1 == ret)
 		return -1;
 
 	/* Disable mouse wheel tracking. */
-	ret = esc_mouse_wh_track_off(ed->buf);
+	ret = esc_mouse_wh_track_off(&ed->buf);
+	if (-1 == ret)
+		return -1;
+
+	/* Disable bracketed paste. */
+	ret = esc_brkt_paste_off(&ed->buf);
 	if (-1 == ret)
 		return -1;
 
@@ -957,8 +1265,13 @@ ed_quit(struct ed *const ed)
 	if (-1 == ret)
 		return -1;
 
-	/* Free content buffer. */
-	vec_free(ed->buf);
+	/* Free content buffer, shadow screen, input and not inserted paste. */
+	buf_free(&ed->buf);
+	buf_refs_free(&ed->refs);
+	iovs_free(&ed->iovs);
+	buf_free(&ed->paste);
+	scr_free(ed->scr);
+	input_free(ed->input);
 
 	/* Close the window. */
 	ret = win_close(ed->win);
@@ -1078,41 +1391,33 @@ ed_switch_mode(struct ed *const ed, const enum mode mode)
 int
 ed_wait_and_proc_key(struct ed *const ed)
 {
-	int ret = 0;
-	char seq[4];
-	size_t seq_len;
-
-	/* Wait key press. */
-	seq_len = term_wait_key(seq, sizeof(seq));
-	if (0 == seq_len)
-		return -1;
-
-	/* Process key sequence if more than one characters readed. */
-	if (seq_len > 1) {
-		/*
-		 * When switching to other modes, the number input will be cleared in the
-		 * normal mode key processing function. This is not done here, so we need
-		 * this line.
-		 */
-		ed_num_input_clr(ed);
+	int ret;
+	char key[INPUT_KEY_MAX_LEN];
+	size_t key_len;
 
-		ret = ed_proc_seq_key(ed, seq, seq_len);
-		return ret;
+	/* Wake up from time to time to redraw loading progress. */
+	if (win_file_is_loading(ed->win) && input_is_empty(ed->input)) {
+		ret = term_wait_input(CFG_LOADING_REDRAW_MS);
+		if (-1 == ret)
+			return -1;
+		/* Return to redraw if there is no input. */
+		if (0 == ret)
+			return 0;
 	}
 
-	/* Process single character keys in different input modes. */
-	switch (ed->mode) {
-	case MODE_NORM:
-		ret = ed_proc_norm_key(ed, seq[0]);
-		break;
-	case MODE_INS:
-		ret = ed_proc_ins_key(ed, seq[0]);
-		ed_num_input_clr(ed);
-		break;
-	case MODE_SEARCH:
-		ret = ed_proc_search_key(ed, seq[0]);
-		ed_num_input_clr(ed);
-		break;
+	/* Wait key presses and read all available input. */
+	ret = input_read(ed->input);
+	if (-1 == ret)
+		return -1;
+
+	/* Process all read keys before drawing. */
+	while (!ed_need_to_quit(ed)) {
+		ret = input_next(ed->input, key, &key_len);
+		if (ret <= 0)
+			return ret;
+		ret = ed_proc_key(ed, key, key_len);
+		if (-1 == ret)
+			return -1;
 	}
-	return ret;
+	return 0;
 }
@@ -11,6 +11,13 @@ struct ed;
  */
 int ed_draw(struct ed *);
 
+/*
+ * Checks that there is input, which is not processed yet, without waiting.
+ *
+ * Returns 1 if there is input, 0 if not and -1 on error.
+ */
+int ed_has_input(const struct ed *);
+
 /*
  * Determines that we need to quit.
  */
@@ -20,12 +27,14 @@ char ed_need_to_quit(const struct ed *);
  * Opens a file and binds editor to specified file descriptors. Do not forget
  * to quit it.
  *
+ * Passed count of threads is used for heavy file operations.
+ *
  * Please quit the editor before printing, for example, error messages. This is
  * needed to disable raw mode and other settings properly.
  *
  * Returns pointer to opaque struct on success and `NULL` on error.
  */
-struct ed *ed_open(const char *, int, int);
+struct ed *ed_open(const char *, int, int, size_t);
 
 /*
  * Quits opened editor.
@@ -40,7 +49,7 @@ int ed_quit(struct ed *);
 void ed_reg_sig(struct ed *, int);
 
 /*
- * Waits key press and processes it.
+ * Waits key presses and processes all of them, which are read at once.
  *
  * Returns 0 on success and -1 on error.
  */
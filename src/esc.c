@@ -2,87 +2,114 @@
 #include <string.h>
 #include "color.h"
 #include "esc.h"
-#include "vec.h"
+#include "buf.h"
 
 int
-esc_alt_scr_on(struct vec *const buf)
+esc_alt_scr_on(struct buf *const buf)
 {
 	int ret;
 
-	ret = vec_append(buf, "\x1b[?1049h", 8);
+	ret = buf_append(buf, "\x1b[?1049h", 8);
 	return ret;
 }
 
 int
-esc_alt_scr_off(struct vec *const buf)
+esc_alt_scr_off(struct buf *const buf)
 {
 	int ret;
 
-	ret = vec_append(buf, "\x1b[?1049l", 8);
+	ret = buf_append(buf, "\x1b[?1049l", 8);
 	return ret;
 }
 
 int
-esc_clr_win(struct vec *const buf)
+esc_brkt_paste_off(struct buf *const buf)
 {
 	int ret;
 
-	ret = vec_append(buf, "\x1b[2J", 4);
+	ret = buf_append(buf, "\x1b[?2004l", 8);
 	return ret;
 }
 
 int
-esc_color_bg(struct vec *const buf, const struct color c)
+esc_brkt_paste_on(struct buf *const buf)
 {
 	int ret;
 
-	ret = vec_append_fmt(buf, "\x1b[48;2;%hhu;%hhu;%hhum", c.r, c.g, c.b);
-	return -1 == ret ? -1 : 0;
+	ret = buf_append(buf, "\x1b[?2004h", 8);
+	return ret;
 }
 
 int
-esc_color_fg(struct vec *const buf, const struct color c)
+esc_clr_win(struct buf *const buf)
 {
 	int ret;
 
-	ret = vec_append_fmt(buf, "\x1b[38;2;%hhu;%hhu;%hhum", c.r, c.g, c.b);
-	return -1 == ret ? -1 : 0;
+	ret = buf_append(buf, "\x1b[2J", 4);
+	return ret;
+}
+
+int
+esc_clr_row_end(struct buf *const buf)
+{
+	int ret;
+
+	ret = buf_append(buf, "\x1b[K", 3);
+	return ret;
+}
+
+int
+esc_color_bg(struct buf *const buf, const struct color *const c)
+{
+	int ret;
+
+	ret = buf_append(buf, c->bg, c->bg_len);
+	return ret;
 }
 
 int
-esc_color_end(struct vec *const buf)
+esc_color_fg(struct buf *const buf, const struct color *const c)
 {
 	int ret;
 
-	ret = vec_append(buf, "\x1b[0m", 4);
+	ret = buf_append(buf, c->fg, c->fg_len);
 	return ret;
 }
 
 int
-esc_cur_hide(struct vec *const buf)
+esc_color_end(struct buf *const buf)
 {
 	int ret;
 
-	ret = vec_append(buf, "\x1b[?25l", 6);
+	ret = buf_append(buf, "\x1b[0m", 4);
+	return ret;
+}
+
+int
+esc_cur_hide(struct buf *const buf)
+{
+	int ret;
+
+	ret = buf_append(buf, "\x1b[?25l", 6);
 	return ret;
 }
 
 int
 esc_cur_set(
-	struct vec *const buf, const unsigned short row, const unsigned short col)
+	struct buf *const buf, const unsigned short row, const unsigned short col)
 {
 	int ret;
 
-	ret = vec_append_fmt(buf, "\x1b[%hu;%huH", row + 1, col + 1);
+	ret = buf_append_fmt(buf, "\x1b[%hu;%huH", row + 1, col + 1);
 	return -1 == ret ? -1 : 0;
 }
 
 int
-esc_cur_show(struct vec *const buf)
+esc_cur_show(struct buf *const buf)
 {
 	int ret;
 
-	ret = vec_append(buf, "\x1b[?25h", 6);
+	ret = buf_append(buf, "\x1b[?25h", 6);
 	return ret;
 }
 
@@ -105,14 +132,34 @@ esc_extr_arrow_key(
 	return -1;
 }
 
+int
+esc_extr_brkt_paste_key(
+	const char *const seq, const size_t len, enum brkt_paste_key *const key)
+{
+	int cmp;
+
+	/* Validate length. */
+	if (6 != len)
+		return -1;
+
+	cmp = strncmp("\x1b[20", seq, 4);
+	/* Validate prefix, paste key and suffix. */
+	if (0 == cmp && BRKT_PASTE_KEY_BEGIN <= seq[4] && seq[4] <= BRKT_PASTE_KEY_END
+			&& '~' == seq[5]) {
+		*key = seq[4];
+		return 0;
+	}
+	return -1;
+}
+
 int
 esc_extr_mouse_wh_key(
 	const char *const seq, const size_t len, enum mouse_wh_key *const key)
 {
 	int cmp;
 
-	/* Validate length. */
-	if (4 != len)
+	/* Validate length. Report also has column and row of the pointer. */
+	if (6 != len)
 		return -1;
 
 	cmp = strncmp("\x1b[M", seq, 3);
@@ -125,28 +172,156 @@ esc_extr_mouse_wh_key(
 }
 
 int
-esc_go_home(struct vec *const buf)
+esc_extr_sync_upd_report(
+	const char *const seq, const size_t len, char *const is_supported)
+{
+	int cmp;
+
+	/* Validate length. Report has one digit of the mode's state. */
+	if (11 != len)
+		return -1;
+
+	cmp = strncmp("\x1b[?2026;", seq, 8);
+	/* Validate prefix and suffix. */
+	if (0 != cmp || 0 != strncmp("$y", &seq[9], 2))
+		return -1;
+
+	/* Mode is set, reset or permanently set, so the terminal knows it. */
+	*is_supported = '1' == seq[8] || '2' == seq[8] || '3' == seq[8];
+	return 0;
+}
+
+int
+esc_go_home(struct buf *const buf)
+{
+	int ret;
+
+	ret = buf_append(buf, "\x1b[H", 3);
+	return ret;
+}
+
+int
+esc_mouse_wh_track_off(struct buf *const buf)
+{
+	int ret;
+
+	ret = buf_append(buf, "\x1b[?1000l", 8);
+	return ret;
+}
+
+int
+esc_mouse_wh_track_on(struct buf *const buf)
+{
+	int ret;
+
+	ret = buf_append(buf, "\x1b[?1000h", 8);
+	return ret;
+}
+
+int
+esc_scroll_down(struct buf *const buf, const unsigned short cnt)
+{
+	int ret;
+
+	ret = buf_append_fmt(buf, "\x1b[%huT", cnt);
+	return -1 == ret ? -1 : 0;
+}
+
+int
+esc_scroll_region(
+	struct buf *const buf, const unsigned short top, const unsigned short bot)
+{
+	int ret;
+
+	ret = buf_append_fmt(buf, "\x1b[%hu;%hur", top + 1, bot + 1);
+	return -1 == ret ? -1 : 0;
+}
+
+int
+esc_scroll_region_reset(struct buf *const buf)
+{
+	int ret;
+
+	ret = buf_append(buf, "\x1b[r", 3);
+	return ret;
+}
+
+int
+esc_scroll_up(struct buf *const buf, const unsigned short cnt)
+{
+	int ret;
+
+	ret = buf_append_fmt(buf, "\x1b[%huS", cnt);
+	return -1 == ret ? -1 : 0;
+}
+
+int
+esc_sgr_reset(struct buf *const buf, struct esc_sgr *const sgr)
+{
+	int ret;
+
+	/* Attributes are already default. */
+	if (0 == sgr->len)
+		return 0;
+
+	ret = esc_color_end(buf);
+	if (-1 == ret)
+		return -1;
+	sgr->attrs = NULL;
+	sgr->len = 0;
+	return 0;
+}
+
+int
+esc_sgr_set(
+	struct buf *const buf,
+	struct esc_sgr *const sgr,
+	const char *const attrs,
+	const size_t len)
+{
+	int ret;
+
+	/* Attributes are not changed. */
+	if (len == sgr->len && (0 == len || 0 == memcmp(attrs, sgr->attrs, len)))
+		return 0;
+
+	/* Reset attributes, which may be not overridden by new ones. */
+	ret = esc_sgr_reset(buf, sgr);
+	if (-1 == ret)
+		return -1;
+
+	/* Set new attributes. */
+	ret = buf_append(buf, attrs, len);
+	if (-1 == ret)
+		return -1;
+	sgr->attrs = attrs;
+	sgr->len = len;
+	return 0;
+}
+
+int
+esc_sync_upd_begin(struct buf *const buf)
 {
 	int ret;
 
-	ret = vec_append(buf, "\x1b[H", 3);
+	ret = buf_append(buf, "\x1b[?2026h", 8);
 	return ret;
 }
 
 int
-esc_mouse_wh_track_off(struct vec *const buf)
+esc_sync_upd_end(struct buf *const buf)
 {
 	int ret;
 
-	ret = vec_append(buf, "\x1b[?1000l", 8);
+	ret = buf_append(buf, "\x1b[?2026l", 8);
 	return ret;
 }
 
 int
-esc_mouse_wh_track_on(struct vec *const buf)
+esc_sync_upd_query(struct buf *const buf)
 {
 	int ret;
 
-	ret = vec_append(buf, "\x1b[?1000h", 8);
+	ret = buf_append(buf, "\x1b[?2026$p", 9);
 	return ret;
 }
@@ -2,7 +2,7 @@
 #define _ESC_H
 
 #include "color.h"
-#include "vec.h"
+#include "buf.h"
 
 enum arrow_key {
 	ARROW_KEY_UP = 'A',
@@ -11,17 +11,31 @@ enum arrow_key {
 	ARROW_KEY_LEFT = 'D',
 };
 
+enum brkt_paste_key {
+	BRKT_PASTE_KEY_BEGIN = '0',
+	BRKT_PASTE_KEY_END = '1',
+};
+
 enum mouse_wh_key {
 	MOUSE_WH_KEY_DOWN = 'a',
 	MOUSE_WH_KEY_UP = '`',
 };
 
+/*
+ * Graphic rendition attributes set on the terminal. Escape sequences are
+ * written only if attributes are changed. Zeroed struct is the default state.
+ */
+struct esc_sgr {
+	const char *attrs; /* Escape sequences of set attributes. */
+	size_t len; /* Length of attributes. 0 if the state is the default one. */
+};
+
 /*
  * Disables alternate screen. Need to restore screen before editor opening.
  *
  * Returns 0 on success and -1 on error.
  */
-int esc_alt_scr_off(struct vec *);
+int esc_alt_scr_off(struct buf *);
 
 /*
  * Enables alternate screen. Need to save screen before editor opening. Do not
@@ -29,56 +43,78 @@ int esc_alt_scr_off(struct vec *);
  *
  * Returns 0 on success and -1 on error.
  * */
-int esc_alt_scr_on(struct vec *);
+int esc_alt_scr_on(struct buf *);
+
+/*
+ * Disables bracketed paste.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int esc_brkt_paste_off(struct buf *);
+
+/*
+ * Enables bracketed paste. Pasted content is surrounded with begin and end
+ * keys, so it can be told apart from typed keys. Do not forget to disable it.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int esc_brkt_paste_on(struct buf *);
 
 /*
  * Clears all window.
  *
  * Returns 0 on success and -1 on error.
  */
-int esc_clr_win(struct vec *);
+int esc_clr_win(struct buf *);
+
+/*
+ * Clears the rest of the row from the cursor.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int esc_clr_row_end(struct buf *);
 
 /*
  * Begins colored background.
  *
  * Returns 0 on success and -1 on error.
  */
-int esc_color_bg(struct vec *, struct color);
+int esc_color_bg(struct buf *, const struct color *);
 
 /*
  * Begins colored foreground.
  *
  * Returns 0 on success and -1 on error.
  */
-int esc_color_fg(struct vec *, struct color);
+int esc_color_fg(struct buf *, const struct color *);
 
 /*
  * Ends colored output.
  *
  * Returns 0 on success and -1 on error.
  */
-int esc_color_end(struct vec *);
+int esc_color_end(struct buf *);
 
 /*
  * Hides the cursor. Used to avoid blinking during redrawing.
  *
  * Returns 0 on success and -1 on error.
  */
-int esc_cur_hide(struct vec *);
+int esc_cur_hide(struct buf *);
 
 /*
  * Sets the cursor in the window. Values start from zero.
  *
  * Returns 0 on success and -1 on error.
  */
-int esc_cur_set(struct vec *, unsigned short, unsigned short);
+int esc_cur_set(struct buf *, unsigned short, unsigned short);
 
 /*
  * Shows the cursor.
  *
  * Returns 0 on success and -1 on error.
  */
-int esc_cur_show(struct vec *);
+int esc_cur_show(struct buf *);
 
 /*
  * Extracts arrow key from sequence.
@@ -89,6 +125,15 @@ int esc_cur_show(struct vec *);
  */
 int esc_extr_arrow_key(const char *, size_t, enum arrow_key *);
 
+/*
+ * Extracts begin or end key of bracketed paste from sequence.
+ *
+ * Returns 0 on success and -1 on error.
+ *
+ * Sets no errors.
+ */
+int esc_extr_brkt_paste_key(const char *, size_t, enum brkt_paste_key *);
+
 /*
  * Extracts mouse wheel key from sequence.
  *
@@ -98,25 +143,106 @@ int esc_extr_arrow_key(const char *, size_t, enum arrow_key *);
  */
 int esc_extr_mouse_wh_key(const char *, size_t, enum mouse_wh_key *);
 
+/*
+ * Extracts support of synchronized updates from the terminal's report.
+ *
+ * Returns 0 on success and -1 on error.
+ *
+ * Sets no errors.
+ */
+int esc_extr_sync_upd_report(const char *, size_t, char *);
+
 /*
  * Moves the current writing pointer to the beginning of the window.
  *
  * Returns 0 on success and -1 on error.
  */
-int esc_go_home(struct vec *);
+int esc_go_home(struct buf *);
 
 /*
  * Disables mouse wheel tracking.
  *
  * Returns 0 on success and -1 on error.
  */
-int esc_mouse_wh_track_off(struct vec *);
+int esc_mouse_wh_track_off(struct buf *);
 
 /*
  * Enables mouse wheel tracking. Do not forget to disable it.
  *
  * Returns 0 on success and -1 on error.
  */
-int esc_mouse_wh_track_on(struct vec *);
+int esc_mouse_wh_track_on(struct buf *);
+
+/*
+ * Scrolls rows of the scroll region down by passed count. Empty rows appear
+ * at the top of the region.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int esc_scroll_down(struct buf *, unsigned short);
+
+/*
+ * Limits scrolling to rows from the first passed row to the second one
+ * inclusive. Values start from zero. Moves the cursor to the beginning of the
+ * window. Do not forget to reset it.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int esc_scroll_region(struct buf *, unsigned short, unsigned short);
+
+/*
+ * Resets scroll region to the whole window.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int esc_scroll_region_reset(struct buf *);
+
+/*
+ * Scrolls rows of the scroll region up by passed count. Empty rows appear at
+ * the bottom of the region.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int esc_scroll_up(struct buf *, unsigned short);
+
+/*
+ * Resets graphic rendition attributes to the default state if they are set.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int esc_sgr_reset(struct buf *, struct esc_sgr *);
+
+/*
+ * Sets graphic rendition attributes passed as escape sequences if they differ
+ * from the current ones. Previous attributes are reset before. Attributes must
+ * be valid until the state is changed again.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int esc_sgr_set(struct buf *, struct esc_sgr *, const char *, size_t);
+
+/*
+ * Begins synchronized update. The terminal holds drawing until its end, so the
+ * frame is shown at once.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int esc_sync_upd_begin(struct buf *);
+
+/*
+ * Ends synchronized update.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int esc_sync_upd_end(struct buf *);
+
+/*
+ * Asks the terminal whether it supports synchronized updates. Supporting
+ * terminal answers with the report, see `esc_extr_sync_upd_report`. Others
+ * do not answer.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int esc_sync_upd_query(struct buf *);
 
 #endif /* _ESC_H */
@@ -1,27 +1,139 @@
 #include <errno.h>
+#include <fcntl.h>
 #include <libgen.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "arena.h"
 #include "cfg.h"
 #include "dt.h"
 #include "file.h"
+#include "line.h"
 #include "math.h"
 #include "str.h"
+#include "tree.h"
+#include "tvec.h"
 #include "vec.h"
 
 enum {
-	LINE_CHARS_CAP_STEP = 128, /* Line's chars capacity reallocation step. */
-	FILE_LINES_CAP_STEP = 32, /* File's lines capacity reallocation step. */
+	FILE_PAGES_CAP_STEP = 64, /* File's pages capacity reallocation step. */
+	FILE_PAGE_LINES_CNT = 1024, /* Lines count of the indexed page. */
+	FILE_PAGE_MAX_LINES_CNT = 2048, /* Page is split if it has more lines. */
+	FILE_PAGES_CACHE_CNT = 64, /* Max count of loaded and not pinned pages. */
+	FILE_READ_BLOCK_SIZE = 65536, /* Size of block to read not mapped file. */
+	FILE_PART_CAP_STEP = 4096, /* Step of line's part, which is not readed. */
+	FILE_BG_LOAD_MIN_SIZE = 8388608, /* Min size to load in background. */
+	FILE_LOAD_CHUNK_SIZE = 4194304, /* Size of chunk loaded by one thread. */
+	FILE_SEARCH_CHUNK_SIZE = 4194304, /* Size of chunk searched by one thread. */
 };
 
 /*
- * Line of the opened file.
+ * Policy of vectors of pages. Pages are appended while loading and removed
+ * from cache one by one, so the default growing and shrinking are used.
  */
-struct line {
-	struct vec *chars; /* Raw content. Does not contain '\n' or '\0'. */
-	char *render; /* Rendered version of the content. */
-	size_t render_len; /* Length of rendered content. */
+static const struct vec_policy file_pages_policy = {
+	FILE_PAGES_CAP_STEP, VEC_GROW_DIV, VEC_SHRINK_DIV
+};
+
+/*
+ * Policy of the cache of pages. The cache is limited, so it is allocated at
+ * once by the step.
+ */
+static const struct vec_policy file_cache_policy = {
+	FILE_PAGES_CACHE_CNT, VEC_GROW_DIV, VEC_SHRINK_DIV
+};
+
+/*
+ * Policy of the line's part while reading. The part is freed after reading,
+ * so it doubles to copy long lines less.
+ */
+static const struct vec_policy file_part_policy = {
+	FILE_PART_CAP_STEP, 1, VEC_SHRINK_DIV
+};
+
+/*
+ * Typed vector of lines. Lines are accessed in hot paths, so it is inlined.
+ */
+TVEC_DEF(lines, struct line)
+
+/*
+ * Consecutive lines of the file. Pages are the sparse index of the file.
+ *
+ * Lines of the mapped page are loaded on demand and evicted if the page is not
+ * used for a long time. The changed page is pinned in memory because its lines
+ * differ from the mapping. Lines are not rendered, so the page is loaded and
+ * unloaded with a few allocations.
+ */
+struct page {
+	size_t lines_cnt; /* Count of lines in the page. */
+	size_t off; /* Offset of the page's content in the mapping. */
+	size_t len; /* Length of the page's content in the mapping. */
+	struct lines lines; /* Loaded lines. */
+	char is_loaded; /* If set, then lines are loaded. */
+	size_t used; /* Tick of the last usage. */
+	char is_pinned; /* If set, then lines can not be loaded again. */
+};
+
+/*
+ * Job of the thread, which indexes pages of the mapped file.
+ */
+struct index_job {
+	const struct file *file; /* File with the mapping. */
+	size_t begin; /* Begin of range where lines start. */
+	size_t end; /* End of range where lines start. */
+	struct vec *pages; /* Indexed pages. */
+	int ret; /* Result of the job. */
+	int err; /* Error number if job failed. */
+	pthread_t thread; /* Thread which runs the job. */
+};
+
+/*
+ * Background loader of the mapped file's pages. Fields below the mutex are
+ * shared with the thread.
+ */
+struct loader {
+	const struct file *file; /* File with the mapping. */
+	size_t begin; /* Begin of range to load. */
+	size_t threads_cnt; /* Count of threads to index chunks. */
+	pthread_t thread; /* Thread which loads pages. */
+	pthread_mutex_t mutex; /* Guards fields below. */
+	pthread_cond_t cond; /* Signaled if pages are loaded or loading is done. */
+	struct vec *pages; /* Loaded pages, which are not taken by the file yet. */
+	size_t lines_cnt; /* Count of lines in not taken pages. */
+	size_t loaded_len; /* Length of loaded content from the mapping begin. */
+	char is_canceled; /* If set, then the thread must stop. */
+	char is_done; /* If set, then the thread finished. */
+	int err; /* Error number if loading failed. */
+};
+
+/*
+ * State shared by jobs of the search. Jobs farther than the nearest found
+ * result are canceled.
+ */
+struct search_state {
+	pthread_mutex_t mutex; /* Guards fields below. */
+	size_t found_job; /* Index of the nearest job, which found result. */
+};
+
+/*
+ * Job of the thread, which searches not pinned pages in the mapping.
+ */
+struct search_job {
+	const char *map; /* Mapping of the file. */
+	const struct search *search; /* Prepared search of the query. */
+	struct page *const *pages; /* Pages in order of searching. */
+	size_t pages_cnt; /* Count of pages. */
+	char is_bwd; /* If set, then pages are searched backward. */
+	size_t idx; /* Index of the job. Jobs with lower index are nearer. */
+	struct search_state *state; /* State shared by jobs. */
+	size_t found_page; /* Index of the page with found result. */
+	const char *found; /* Found result or `NULL` if not found. */
+	pthread_t thread; /* Thread which runs the job. */
 };
 
 /*
@@ -30,15 +142,79 @@ struct line {
 struct file {
 	char *path; /* Path of readed file. This is where the default save occurs. */
 	char is_dirty; /* If set, then the file has unsaved changes. */
-	struct vec *lines; /* lines of file. There is always at least one line. */
+	struct tree *pages; /* Pages weighted by lines count. There is always a line. */
+	struct vec *cache; /* Pointers to loaded pages, which are not pinned. */
+	size_t tick; /* Counter of pages usages. */
+	char *map; /* Private read only mapping of the file, its copy or `NULL`. */
+	size_t map_len; /* Length of the mapping. */
+	int map_fd; /* Descriptor of the mapped file to check its size. */
+	dev_t map_dev; /* Device of the mapped file. */
+	ino_t map_ino; /* Inode of the mapped file. */
+	char is_map_copied; /* If set, then the mapping does not depend on file. */
+	struct loader *loader; /* Background loader or `NULL` if file is loaded. */
+	size_t threads_cnt; /* Count of threads to load and search. */
+	size_t loaded_len; /* Length of loaded content from the mapping begin. */
+	struct arena *arena; /* Arena of characters of readed lines. */
+	size_t next_id; /* Identity of the next new line. */
+	size_t edit_id; /* Identity of the line changed by the last edit. */
+	size_t edit_gen; /* Generation of the line made by the last edit. */
+	struct pub_edit edit; /* The last edit of a line. */
 };
 
+/*
+ * Copies characters of the finished line to the file's arena and appends the
+ * line to the last page of the file.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+static int file_append_line(struct file *, const char *, size_t);
+
+/*
+ * Moves pages from passed container to the end of the file. Pages, which are
+ * not moved on error, stay in the container.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+static int file_append_pages(struct file *, struct vec *);
+
 /*
  * Allocates empty file container. Do not forget to free it.
  *
  * Returns pointer to opaque struct on succcess and `NULL` on error.
  */
-static struct file *file_alloc(const char *);
+static struct file *file_alloc(const char *, size_t);
+
+/*
+ * Checks that the mapped file is not truncated. Reading the truncated part of
+ * the mapping raises `SIGBUS`, so check it before reading the mapping.
+ *
+ * Returns 0 on success and -1 on error.
+ *
+ * Sets `EIO` if the file is truncated.
+ */
+static int file_check_map(const struct file *);
+
+/*
+ * Copies the mapping to memory and moves lines to the copy, so the mapped file
+ * can be truncated and rewritten in place without losing content of lines.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+static int file_copy_map(struct file *);
+
+/*
+ * Remembers the last edit of passed line, so the line's previous generation
+ * can be patched instead of being processed again.
+ */
+static void file_edit(
+	struct file *, const struct line *, size_t, size_t, size_t, char);
+
+/*
+ * Unloads cached page, which is not used for the longest time.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+static int file_evict_page(struct file *);
 
 /*
  * Frees file allocated file.
@@ -46,123 +222,225 @@ static struct file *file_alloc(const char *);
 static void file_free(struct file *);
 
 /*
- * Reads lines from the file.
+ * Frees pages and container with them.
+ */
+static void file_free_pages(struct vec *);
+
+/*
+ * Finds line by index and loads its page if needed.
  *
- * Returns 0 on success and -1 on error. Note that you need to free readed
- * lines.
+ * Returns pointer to line on success and `NULL` on error.
+ *
+ * Sets `EINVAL` if index is invalid.
  */
-static int file_read(struct file *, FILE *);
+static struct line *file_get_line(struct file *, size_t);
 
 /*
- * Writes lines to the file.
+ * Like the default line getting function, but also pins the line's page to
+ * change the line.
  *
- * Returns written bytes count on success and 0 on error.
+ * Returns pointer to line on success and `NULL` on error.
+ *
+ * Sets `EINVAL` if index is invalid.
  */
-static size_t file_write(const struct file *, FILE *);
+static struct line *file_get_line_to_edit(struct file *, size_t);
 
 /*
- * Appends passed chars to line and renders updated line.
+ * Splits the mapping to pages. The first page is indexed immediately and the
+ * rest of big mapping is loaded in background using passed count of threads.
  *
  * Returns 0 on success and -1 on error.
  */
-static int line_append(struct line *, const char *, size_t);
+static int file_index_map(struct file *, size_t);
 
 /*
- * Breaks the line at passed index. Writes broken right part to the passed
- * line.
+ * Like the default range indexing function, but splits the range to smaller
+ * ranges and indexes them in parallel. The results are joined in order.
  *
- * Returns 0 on success an -1 on error.
+ * Returns 0 on success and -1 on error.
  */
-int line_break(struct line *, size_t, struct line *);
+static int file_index_map_par(
+	const struct file *, size_t, size_t, size_t, struct vec *);
 
 /*
- * Calculates render's capacity using characters. Useful after characters
- * update.
+ * Creates pages of lines, which start in the passed range of the mapping, and
+ * appends them to the passed container. Lines may end after the range.
+ *
+ * Returns 0 on success and -1 on error.
  */
-static size_t line_calc_render_cap(struct line *);
+static int file_index_range(const struct file *, size_t, size_t, struct vec *);
 
 /*
- * Cuts a line, shrinks its capacity and rerenders it. The argument specifies
- * how many first characters will remain.
+ * Inserts passed count of lines at passed index. Splits the page if it became
+ * too big.
  *
- * Returns 0 on success and -1 on error.
+ * Returns 0 on success and -1 on error. Lines are not inserted on error.
+ *
+ * Sets `EINVAL` if passed index is invalid.
+ */
+static int file_ins_lines(struct file *, size_t, const struct line *, size_t);
+
+/*
+ * Checks that passed path refers to the mapped file.
+ */
+static char file_is_mapped(const struct file *, const char *);
+
+/*
+ * Gets the last edit if it made the current generation of passed line.
+ *
+ * Returns pointer to the edit or `NULL` if the line is changed differently.
  */
-static int line_cut(struct line *, size_t);
+static const struct pub_edit *file_line_edit(
+	const struct file *, const struct line *);
 
 /*
- * Deletes character from line at passed index and after rerenders the line.
+ * Starts background loading of pages from passed offset of the mapping using
+ * passed count of threads.
  *
  * Returns 0 on success and -1 on error.
  */
-int line_del_char(struct line *, size_t);
+static int file_load_bg(struct file *, size_t, size_t);
 
 /*
- * Frees allocated line's buffer.
+ * Marks the page as used and loads its lines if they are not loaded. Evicts
+ * other page if there are too many loaded pages.
+ *
+ * Returns 0 on success and -1 on error.
  */
-static void line_free(struct line *);
+static int file_load_page(struct file *, struct page *);
 
 /*
- * Initializes line with zeros. Do not forget to free it.
+ * Maps the file by descriptor. Does nothing if file can not be mapped, so use
+ * reading instead.
  *
  * Returns 0 on success and -1 on error.
  */
-static int line_init(struct line *);
+static int file_map(struct file *, int);
 
 /*
- * Inserts character to line at passed index and after rerenders the line.
+ * Pins the page in memory. Use it before lines changing.
  *
  * Returns 0 on success and -1 on error.
  */
-int line_ins_char(struct line *, size_t, char);
+static int file_pin_page(struct file *, struct page *);
 
 /*
- * Reads line characters from a file without `'\n'`.
+ * Reads lines from the file descriptor by big blocks.
  *
- * Returns 1 if line readed, 0 if EOF reached and there is no line to read and
- * -1 if error.
+ * Returns 0 on success and -1 on error. Note that you need to free readed
+ * lines.
  */
-static int line_read(struct line *, FILE *);
+static int file_read(struct file *, int);
 
 /*
- * Allocates big enough buffer and renders characters to it how it look in the
- * window.
+ * Removes line by its index and writes it to passed pointer. Removes the page
+ * if it became empty.
  *
  * Returns 0 on success and -1 on error.
+ *
+ * Sets `EINVAL` if passed index is invalid.
  */
-static int line_render(struct line *);
+static int file_rm_line(struct file *, size_t, struct line *);
 
 /*
- * Renders line characters in existing buffer how it look in the window. Make
- * sure that render buffer capacity is big enough.
+ * Writes lines to the opened file, flushes and closes it.
+ *
+ * Returns written bytes count on success and 0 on error.
  */
-static void line_render_no_alloc(struct line *);
+static size_t file_save_to(const struct file *, FILE *);
 
 /*
- * Searches query backward.
+ * Searches consecutive not pinned pages from the page at passed position using
+ * all threads. Moves passed position and index of the page's first line to the
+ * last searched page. Sets index and position of the result if found.
  *
- * Returns 1 if result found, 0 if no result and -1 if starting index is
- * invalid.
+ * Returns 1 if result found, 0 if no result and -1 on error.
+ */
+static int file_search_pages(
+	struct file *,
+	size_t *,
+	size_t *,
+	const struct search *,
+	char,
+	size_t *,
+	size_t *);
+
+/*
+ * Splits the page at passed position if it has too many lines. The last lines
+ * are moved to new pages of the indexed page's size until the page fits.
  *
- * Sets `EINVAL` if index is invalid.
+ * Returns 0 on success and -1 on error.
+ */
+static int file_split_page(struct file *, size_t);
+
+/*
+ * Stops background loading if it is running and frees pages, which were not
+ * taken.
+ */
+static void file_stop_loading(struct file *);
+
+/*
+ * Writes lines to the file.
+ *
+ * Returns written bytes count on success and 0 on error.
+ */
+static size_t file_write(const struct file *, FILE *);
+
+/*
+ * Runs the indexing job. Use it as thread's routine.
+ */
+static void *index_job_run(void *);
+
+/*
+ * Loads pages of the mapping by chunks and passes them to the file. Use it as
+ * thread's routine.
  */
-static int line_search_bwd(const struct line *, size_t *, const char *);
+static void *loader_run(void *);
 
 /*
- * Searches query forward.
+ * Allocates pinned page with empty lines container. Do not forget to free it.
  *
- * Returns 1 if result found, 0 if no result and -1 if starting index is
- * invalid.
+ * Returns pointer to page on success and `NULL` on error.
+ */
+static struct page *page_alloc_pinned(void);
+
+/*
+ * Finds line of found characters in the mapped content of not pinned page.
+ * Moves passed index from the page's first line to the found line and sets
+ * position in the line.
+ */
+static void page_find(
+	const struct page *, const char *, const char *, size_t *, size_t *);
+
+/*
+ * Frees page and its loaded lines.
+ */
+static void page_free(struct page *);
+
+/*
+ * Creates lines of the page, which point to the passed mapping.
  *
- * Sets `EINVAL` if index is invalid.
+ * Returns 0 on success and -1 on error.
  */
-static int line_search_fwd(const struct line *, size_t *, const char *);
+static int page_load(struct page *, const char *);
 
 /*
- * Writes a line to the file with `'\n'` at the end.
+ * Frees loaded lines of the page.
+ */
+static void page_unload(struct page *);
+
+/*
+ * Writes page's lines to the file. Writes mapped content if the page is not
+ * pinned.
  *
  * Returns written bytes count on success and 0 on error.
  */
-static size_t line_write(const struct line *, FILE *);
+static size_t page_write(const struct page *, const char *, FILE *);
+
+/*
+ * Runs the search job. Use it as thread's routine.
+ */
+static void *search_job_run(void *);
 
 int
 file_absorb_next_line(struct file *const file, const size_t idx)
@@ -170,22 +448,31 @@ file_absorb_next_line(struct file *const file, const size_t idx)
 	int ret;
 	struct line next;
 	struct line *curr;
+	size_t len;
+
+	/* Validate that current line exists before next line removing. */
+	if (idx >= tree_weight(file->pages)) {
+		errno = EINVAL;
+		return -1;
+	}
 
 	/* Remove next line. */
-	ret = vec_rm(file->lines, idx + 1, &next);
+	ret = file_rm_line(file, idx + 1, &next);
 	if (-1 == ret)
 		return -1;
 
 	/* Append current line with next line's chars if next line is not empty. */
-	if (vec_len(next.chars) > 0) {
-		/* Get current line here because vector may realloc after removing. */
-		curr = vec_get(file->lines, idx);
+	if (line_len(&next) > 0) {
+		/* Get current line here because its page may change after removing. */
+		curr = file_get_line_to_edit(file, idx);
 		if (NULL == curr)
 			goto ret_free;
 
-		ret = line_append(curr, vec_items(next.chars), vec_len(next.chars));
+		len = line_len(curr);
+		ret = line_append(curr, line_chars(&next), line_len(&next));
 		if (-1 == ret)
 			goto ret_free;
+		file_edit(file, curr, len, line_len(&next), 0, '\0');
 	}
 
 	/* Mark file as dirty. */
@@ -200,8 +487,85 @@ ret_free:
 	return -1;
 }
 
+static int
+file_append_line(
+	struct file *const file, const char *const chars, const size_t len)
+{
+	int ret;
+	size_t cnt;
+	char *copy;
+	struct line line;
+	struct page *page = NULL;
+
+	/* Copy characters to the arena. */
+	copy = arena_get(file->arena, len);
+	if (NULL == copy)
+		return -1;
+	memcpy(copy, chars, len);
+
+	/* Create line, which points to the copy. */
+	line_map(&line, copy, len, file->next_id++);
+
+	/* Get last page. */
+	cnt = tree_len(file->pages);
+	if (cnt > 0)
+		page = tree_get(file->pages, cnt - 1);
+
+	/* Begin new page if there is no pages or the last one is full. */
+	if (NULL == page || page->lines_cnt >= FILE_PAGE_LINES_CNT) {
+		page = page_alloc_pinned();
+		if (NULL == page)
+			goto err_free;
+
+		/* The page will be filled, so allocate lines at once. */
+		ret = lines_reserve(&page->lines, FILE_PAGE_LINES_CNT);
+		if (-1 == ret) {
+			page_free(page);
+			goto err_free;
+		}
+
+		ret = tree_ins(file->pages, cnt++, page, 0);
+		if (-1 == ret) {
+			page_free(page);
+			goto err_free;
+		}
+	}
+
+	/* Append the line. */
+	ret = lines_append(&page->lines, &line, 1);
+	if (-1 == ret)
+		goto err_free;
+	page->lines_cnt++;
+	return tree_set_weight(file->pages, cnt - 1, page->lines_cnt);
+err_free:
+	line_free(&line);
+	return -1;
+}
+
+static int
+file_append_pages(struct file *const file, struct vec *const pages)
+{
+	int ret;
+	size_t i;
+	struct page **const items = vec_items(pages);
+	const size_t len = vec_len(pages);
+
+	/* Insert pages to the end of the tree. */
+	for (i = 0; i < len; i++) {
+		ret = tree_ins(
+			file->pages, tree_len(file->pages), items[i], items[i]->lines_cnt);
+		if (-1 == ret)
+			break;
+	}
+
+	/* Leave only not moved pages in the container. */
+	memmove(items, &items[i], (len - i) * sizeof(*items));
+	vec_set_len(pages, len - i);
+	return i == len ? 0 : -1;
+}
+
 static struct file*
-file_alloc(const char *const path)
+file_alloc(const char *const path, const size_t threads_cnt)
 {
 	struct file *file;
 
@@ -215,14 +579,38 @@ file_alloc(const char *const path)
 	if (NULL == file->path)
 		goto err_free_opaque;
 
-	/* Allocate lines container to store lines. */
-	file->lines = vec_alloc(sizeof(struct line), FILE_LINES_CAP_STEP);
-	if (NULL == file->lines)
+	/* Allocate tree to store pages. */
+	file->pages = tree_alloc();
+	if (NULL == file->pages)
 		goto err_free_opaque_and_path;
 
+	/* Allocate container for loaded pages. */
+	file->cache = vec_alloc(sizeof(struct page *), &file_cache_policy);
+	if (NULL == file->cache)
+		goto err_free_opaque_and_path_and_pages;
+
+	/* Allocate arena for lines, which live until closing. */
+	file->arena = arena_alloc();
+	if (NULL == file->arena)
+		goto err_free_opaque_and_path_and_pages_and_cache;
+
 	/* Initialize other fields. */
 	file->is_dirty = 0;
+	file->tick = 0;
+	file->map = NULL;
+	file->map_len = 0;
+	file->map_fd = -1;
+	file->is_map_copied = 0;
+	file->loader = NULL;
+	file->threads_cnt = threads_cnt;
+	file->loaded_len = 0;
+	file->next_id = 0;
+	file->edit_id = SIZE_MAX;
 	return file;
+err_free_opaque_and_path_and_pages_and_cache:
+	vec_free(file->cache);
+err_free_opaque_and_path_and_pages:
+	tree_free(file->pages);
 err_free_opaque_and_path:
 	free(file->path);
 err_free_opaque:
@@ -236,19 +624,23 @@ file_break_line(struct file *const file, const size_t idx, const size_t pos)
 	int ret;
 	struct line new_line;
 	struct line *line;
+	size_t len;
 
 	/* Get line. */
-	line = vec_get(file->lines, idx);
+	line = file_get_line_to_edit(file, idx);
 	if (NULL == line)
 		return -1;
 
-	/* Break line. */
-	ret = line_break(line, pos, &new_line);
+	/* Break line. Its right part is removed if it is not empty. */
+	len = line_len(line);
+	ret = line_break(line, pos, &new_line, file->next_id++);
 	if (-1 == ret)
 		return -1;
+	if (pos < len)
+		file_edit(file, line, pos, 0, len - pos, '\0');
 
 	/* Insert new line. */
-	ret = vec_ins(file->lines, idx + 1, &new_line, 1);
+	ret = file_ins_lines(file, idx + 1, &new_line, 1);
 	if (-1 == ret)
 		goto err_free;
 
@@ -271,16 +663,29 @@ file_del_char(struct file *const file, const size_t idx, const size_t pos)
 {
 	int ret;
 	struct line *line;
+	const char *chars;
+	size_t gap_idx;
+	size_t gap_len;
+	char ch;
 
 	/* Check line not found. */
-	line = vec_get(file->lines, idx);
+	line = file_get_line_to_edit(file, idx);
 	if (NULL == line)
 		return -1;
 
-	/* Delete character in line. */
+	/* Check character not found. */
+	if (pos >= line_len(line)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Delete character in line. Remember it to describe the edit. */
+	chars = line_raw(line, &gap_idx, &gap_len);
+	ch = chars[pos < gap_idx ? pos : pos + gap_len];
 	ret = line_del_char(line, pos);
 	if (-1 == ret)
 		return -1;
+	file_edit(file, line, pos, 0, 1, ch);
 
 	/* Mark file as dirty. */
 	file->is_dirty = 1;
@@ -294,13 +699,13 @@ file_del_line(struct file *const file, const size_t idx)
 	struct line line;
 
 	/* Remember that file must contain at least one line. */
-	if (vec_len(file->lines) <= 1) {
+	if (tree_weight(file->pages) <= 1) {
 		errno = ENOSYS;
 		return -1;
 	}
 
 	/* Remove line using index. */
-	ret = vec_rm(file->lines, idx, &line);
+	ret = file_rm_line(file, idx, &line);
 	if (-1 == ret)
 		return -1;
 	line_free(&line);
@@ -310,174 +715,984 @@ file_del_line(struct file *const file, const size_t idx)
 	return 0;
 }
 
-static void
-file_free(struct file *const file)
-{
-	struct line *lines;
-	size_t len;
-
-	/* Get lines and lines count. */
-	lines = vec_items(file->lines);
-	len = vec_len(file->lines);
-
-	/* Free lines . */
-	while (len-- > 0)
-		line_free(&lines[len]);
-	vec_free(file->lines);
-
-	/* Freeing the path since we cloned it earlier. */
-	free(file->path);
-	/* Free allocated opaque struct. */
-	free(file);
-}
-
-int
-file_ins_char(
-	struct file *const file, const size_t idx, const size_t pos, const char ch)
+static int
+file_check_map(const struct file *const file)
 {
 	int ret;
-	struct line *line;
+	struct stat st;
 
-	/* Get line. */
-	line = vec_get(file->lines, idx);
-	if (NULL == line)
-		return -1;
+	/* Readed file and copied mapping do not depend on the file. */
+	if (NULL == file->map || file->is_map_copied)
+		return 0;
 
-	/* Insert new character. */
-	ret = line_ins_char(line, pos, ch);
+	ret = fstat(file->map_fd, &st);
 	if (-1 == ret)
 		return -1;
-
-	/* Mark file as dirty. */
-	file->is_dirty = 1;
+	if ((size_t)st.st_size < file->map_len) {
+		errno = EIO;
+		return -1;
+	}
 	return 0;
 }
 
-int
-file_ins_empty_line(struct file *const file, const size_t idx)
+static int
+file_copy_map(struct file *const file)
 {
 	int ret;
-	struct line empty_line;
+	size_t i;
+	size_t j;
+	char *copy;
+	struct page *page;
 
-	/* Initialize empty line. */
-	ret = line_init(&empty_line);
+	if (file->is_map_copied)
+		return 0;
+	ret = file_check_map(file);
 	if (-1 == ret)
 		return -1;
 
-	/* Insert empty line. */
-	ret = vec_ins(file->lines, idx, &empty_line, 1);
-	if (-1 == ret) {
-		line_free(&empty_line);
+	/* Truncation of the file drops even changed pages of private mapping. */
+	copy = malloc(file->map_len);
+	if (NULL == copy)
 		return -1;
+	memcpy(copy, file->map, file->map_len);
+
+	/* Move loaded lines, which point to the mapping, to the copy. */
+	for (i = 0; i < tree_len(file->pages); i++) {
+		page = tree_get(file->pages, i);
+		if (!page->is_loaded)
+			continue;
+		for (j = 0; j < page->lines.len; j++)
+			line_remap(
+				lines_at(&page->lines, j), file->map, file->map_len, copy);
 	}
 
-	/* Mark file as dirty. */
-	file->is_dirty = 1;
+	/* Errors checking here is useless. */
+	munmap(file->map, file->map_len);
+	close(file->map_fd);
+	file->map = copy;
+	file->map_fd = -1;
+	file->is_map_copied = 1;
 	return 0;
 }
 
-char
-file_is_dirty(const struct file *const file)
+static void
+file_edit(
+	struct file *const file,
+	const struct line *const line,
+	const size_t idx,
+	const size_t ins_len,
+	const size_t del_len,
+	const char del_ch)
 {
-	return file->is_dirty;
+	file->edit_id = line->id;
+	file->edit_gen = line->gen;
+	file->edit.idx = idx;
+	file->edit.ins_len = ins_len;
+	file->edit.del_len = del_len;
+	file->edit.del_ch = del_ch;
 }
 
-int
-file_line(
-	const struct file *const file, const size_t idx, struct pub_line *const line)
+static int
+file_evict_page(struct file *const file)
 {
-	const struct line *internal;
+	int ret;
+	size_t i;
+	size_t lru = 0;
+	struct page *page;
+	struct page *const *const cache = vec_items(file->cache);
 
-	/* Get internal line struct. */
-	internal = vec_get(file->lines, idx);
-	if (NULL == line)
-		return -1;
+	/* Find the least recently used page. */
+	for (i = 1; i < vec_len(file->cache); i++)
+		if (cache[i]->used < cache[lru]->used)
+			lru = i;
 
-	/* Copy pointers and values to public line. */
-	line->chars = vec_items(internal->chars);
-	line->len = vec_len(internal->chars);
-	line->render = internal->render;
-	line->render_len = internal->render_len;
+	/* Remove the page from cache and free its lines. */
+	ret = vec_rm(file->cache, lru, &page);
+	if (-1 == ret)
+		return -1;
+	page_unload(page);
 	return 0;
 }
 
-size_t
-file_lines_cnt(const struct file *const file)
+static void
+file_free(struct file *const file)
 {
-	return vec_len(file->lines);
+	size_t i;
+
+	/* Stop loading before freeing of pages, which are used by the loader. */
+	file_stop_loading(file);
+
+	/* Free pages. Cache only points to some of them. */
+	for (i = 0; i < tree_len(file->pages); i++)
+		page_free(tree_get(file->pages, i));
+	tree_free(file->pages);
+	vec_free(file->cache);
+
+	/* Free memory of all lines at once after freeing of lines. */
+	arena_free(file->arena);
+
+	/* Unmap the file after freeing of lines, which point to the mapping. */
+	if (file->is_map_copied) {
+		free(file->map);
+	} else if (NULL != file->map) {
+		munmap(file->map, file->map_len);
+		/* Errors checking here is useless. */
+		close(file->map_fd);
+	}
+
+	/* Freeing the path since we cloned it earlier. */
+	free(file->path);
+	/* Free allocated opaque struct. */
+	free(file);
 }
 
-struct file*
-file_open(const char *const path)
+static void
+file_free_pages(struct vec *const pages)
 {
-	int ret;
-	FILE *inner_file;
-	struct file *file;
+	struct page **items;
+	size_t len;
+
+	/* Get pages and pages count. */
+	items = vec_items(pages);
+	len = vec_len(pages);
+
+	/* Free pages. */
+	while (len-- > 0)
+		page_free(items[len]);
+	vec_free(pages);
+}
+
+static struct line*
+file_get_line(struct file *const file, const size_t idx)
+{
+	int ret;
+	size_t pos;
+	size_t first;
+	struct page *page;
+
+	/* Lines may point to the mapping, so check it before any access. */
+	ret = file_check_map(file);
+	if (-1 == ret)
+		return NULL;
+
+	/* Find page. Index is validated here. */
+	page = tree_find(file->pages, idx, &pos, &first);
+	if (NULL == page)
+		return NULL;
+
+	/* Load the page. */
+	ret = file_load_page(file, page);
+	if (-1 == ret)
+		return NULL;
+	return lines_at(&page->lines, idx - first);
+}
+
+static struct line*
+file_get_line_to_edit(struct file *const file, const size_t idx)
+{
+	int ret;
+	size_t pos;
+	size_t first;
+	struct line *line;
+
+	/* Get line and load its page. */
+	line = file_get_line(file, idx);
+	if (NULL == line)
+		return NULL;
+
+	/* Pin the loaded page. */
+	ret = file_pin_page(file, tree_find(file->pages, idx, &pos, &first));
+	if (-1 == ret)
+		return NULL;
+	return line;
+}
+
+static int
+file_index_map(struct file *const file, const size_t threads_cnt)
+{
+	int ret;
+	size_t i;
+	size_t head = file->map_len;
+	const char *nl;
+	struct vec *pages;
+
+	/* Find end of the first page of big file to draw the first screen soon. */
+	if (file->map_len >= FILE_BG_LOAD_MIN_SIZE) {
+		for (i = 0, head = 0; i < FILE_PAGE_LINES_CNT && head < file->map_len; i++) {
+			nl = str_chr(&file->map[head], file->map_len - head, '\n');
+			head = NULL == nl ? file->map_len : (size_t)(nl - file->map) + 1;
+		}
+	}
+
+	/* Allocate container for indexed pages. */
+	pages = vec_alloc(sizeof(struct page *), &file_pages_policy);
+	if (NULL == pages)
+		return -1;
+
+	/* Index the beginning of the file. Small file is indexed entirely. */
+	ret = file_index_range(file, 0, head, pages);
+	if (0 == ret)
+		ret = file_append_pages(file, pages);
+	file_free_pages(pages);
+	if (-1 == ret)
+		return -1;
+	file->loaded_len = head;
+
+	/* Load the rest in background. */
+	if (head < file->map_len)
+		return file_load_bg(file, head, threads_cnt);
+	return 0;
+}
+
+static int
+file_index_map_par(
+	const struct file *const file,
+	const size_t begin,
+	const size_t end,
+	const size_t threads_cnt,
+	struct vec *const pages)
+{
+	int ret;
+	size_t i;
+	size_t started;
+	struct index_job *jobs;
+
+	/* Allocate jobs. */
+	jobs = calloc(threads_cnt, sizeof(*jobs));
+	if (NULL == jobs)
+		return -1;
+
+	/* Split the range to ranges of equal size and start jobs. */
+	for (started = 0; started < threads_cnt; started++) {
+		jobs[started].file = file;
+		jobs[started].begin = begin + (end - begin) / threads_cnt * started;
+		jobs[started].end = started + 1 == threads_cnt
+			? end
+			: begin + (end - begin) / threads_cnt * (started + 1);
+		jobs[started].pages = vec_alloc(
+			sizeof(struct page *), &file_pages_policy);
+		if (NULL == jobs[started].pages)
+			goto err_join;
+
+		ret = pthread_create(
+			&jobs[started].thread, NULL, index_job_run, &jobs[started]);
+		if (0 != ret) {
+			errno = ret;
+			vec_free(jobs[started].pages);
+			goto err_join;
+		}
+	}
+
+	/* Wait all jobs and check their results. */
+	for (i = 0; i < threads_cnt; i++)
+		pthread_join(jobs[i].thread, NULL);
+	for (i = 0; i < threads_cnt; i++) {
+		if (-1 == jobs[i].ret) {
+			errno = jobs[i].err;
+			goto err_free;
+		}
+	}
+
+	/* Join indexed pages in order. */
+	for (i = 0; i < threads_cnt; i++) {
+		ret = vec_append(
+			pages, vec_items(jobs[i].pages), vec_len(jobs[i].pages));
+		if (-1 == ret)
+			goto err_free;
+
+		/* Pages are moved to the result, so free only the container. */
+		vec_free(jobs[i].pages);
+		jobs[i].pages = NULL;
+	}
+
+	free(jobs);
+	return 0;
+err_join:
+	/* Wait started jobs to free their results. */
+	for (i = 0; i < started; i++)
+		pthread_join(jobs[i].thread, NULL);
+err_free:
+	/* Free pages, which were not moved to the result. */
+	for (i = 0; i < started; i++)
+		if (NULL != jobs[i].pages)
+			file_free_pages(jobs[i].pages);
+	free(jobs);
+	return -1;
+}
+
+static int
+file_index_range(
+	const struct file *const file,
+	const size_t begin,
+	const size_t end,
+	struct vec *const pages)
+{
+	int ret;
+	struct page *page = NULL;
+	const char *start = &file->map[begin];
+	const char *const map_end = &file->map[file->map_len];
+	const char *nl;
+
+	/* Skip the line, which started before the range. */
+	if (begin > 0) {
+		nl = str_chr(&start[-1], map_end - start + 1, '\n');
+		if (NULL == nl)
+			return 0;
+		start = nl + 1;
+	}
+
+	while (start < &file->map[end]) {
+		/* Begin new page. */
+		if (NULL == page) {
+			page = calloc(1, sizeof(*page));
+			if (NULL == page)
+				return -1;
+			page->off = start - file->map;
+		}
+
+		/* Find end of the line. The last line may have no '\n'. */
+		nl = str_chr(start, map_end - start, '\n');
+		start = NULL == nl ? map_end : nl + 1;
+
+		/* Append the page if it is full or the range is over. */
+		if (++page->lines_cnt == FILE_PAGE_LINES_CNT || start >= &file->map[end]) {
+			page->len = start - &file->map[page->off];
+			ret = vec_append(pages, &page, 1);
+			if (-1 == ret) {
+				page_free(page);
+				return -1;
+			}
+			page = NULL;
+		}
+	}
+	return 0;
+}
+
+int
+file_ins_char(
+	struct file *const file, const size_t idx, const size_t pos, const char ch)
+{
+	int ret;
+	struct line *line;
+
+	/* Get line. */
+	line = file_get_line_to_edit(file, idx);
+	if (NULL == line)
+		return -1;
+
+	/* Insert new character. */
+	ret = line_ins_char(line, pos, ch);
+	if (-1 == ret)
+		return -1;
+	file_edit(file, line, pos, 1, 0, '\0');
+
+	/* Mark file as dirty. */
+	file->is_dirty = 1;
+	return 0;
+}
+
+int
+file_ins_empty_line(struct file *const file, const size_t idx)
+{
+	int ret;
+	struct line empty_line;
+
+	/* Initialize empty line. */
+	line_init(&empty_line, file->next_id++);
+
+	/* Insert empty line. */
+	ret = file_ins_lines(file, idx, &empty_line, 1);
+	if (-1 == ret) {
+		line_free(&empty_line);
+		return -1;
+	}
+
+	/* Mark file as dirty. */
+	file->is_dirty = 1;
+	return 0;
+}
+
+static int
+file_ins_lines(
+	struct file *const file,
+	const size_t idx,
+	const struct line *const lines,
+	const size_t cnt)
+{
+	int ret;
+	size_t pos = 0;
+	size_t first = 0;
+	struct page *page;
+	const size_t lines_cnt = tree_weight(file->pages);
+
+	/* Validate index. */
+	if (idx > lines_cnt) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Create the first page if there are no pages. */
+	if (0 == tree_len(file->pages)) {
+		page = page_alloc_pinned();
+		if (NULL == page)
+			return -1;
+
+		ret = tree_ins(file->pages, 0, page, 0);
+		if (-1 == ret) {
+			page_free(page);
+			return -1;
+		}
+	}
+
+	/* Find page. Line after the last line is inserted to the last page. */
+	if (0 == lines_cnt)
+		page = tree_get(file->pages, 0);
+	else
+		page = tree_find(
+			file->pages, idx == lines_cnt ? idx - 1 : idx, &pos, &first);
+
+	/* Load and pin the page to insert the line. */
+	ret = file_load_page(file, page);
+	if (-1 == ret)
+		return -1;
+	ret = file_pin_page(file, page);
+	if (-1 == ret)
+		return -1;
+
+	/* Insert the lines. */
+	ret = lines_ins(&page->lines, idx - first, lines, cnt);
+	if (-1 == ret)
+		return -1;
+	page->lines_cnt += cnt;
+	tree_set_weight(file->pages, pos, page->lines_cnt);
+
+	/*
+	 * Split the page if it became too big. Lines are already inserted, so the
+	 * page just stays big if splitting fails. It is split by the next insertion.
+	 */
+	file_split_page(file, pos);
+	return 0;
+}
+
+int
+file_ins_str(
+	struct file *const file,
+	const size_t idx,
+	const size_t pos,
+	const char *const chars,
+	const size_t len)
+{
+	int ret;
+	struct line *line;
+	struct line inner;
+	struct line tail;
+	struct lines new;
+	const char *begin;
+	const char *end;
+	const char *last;
+	char *copy;
+	size_t line_len_before;
+	const char *const first_end = memchr(chars, '\n', len);
+
+	/* Get line. */
+	line = file_get_line_to_edit(file, idx);
+	if (NULL == line)
+		return -1;
+
+	/* Validate insertion position. */
+	line_len_before = line_len(line);
+	if (pos > line_len_before) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Insert characters without line breaks to the line at once. */
+	if (NULL == first_end) {
+		ret = line_ins(line, pos, chars, len);
+		if (-1 == ret)
+			return -1;
+		file_edit(file, line, pos, len, 0, '\0');
+		file->is_dirty = 1;
+		return 0;
+	}
+
+	/*
+	 * Copy characters after the first line break to the arena. Inner lines point
+	 * to the copy like lines of the readed file.
+	 */
+	begin = first_end + 1;
+	copy = arena_get(file->arena, &chars[len] - begin);
+	if (NULL == copy)
+		return -1;
+	memcpy(copy, begin, &chars[len] - begin);
+	last = &copy[&chars[len] - begin];
+
+	/* Create inner lines. */
+	lines_init(&new);
+	begin = copy;
+	while (NULL != (end = memchr(begin, '\n', last - begin))) {
+		line_map(&inner, begin, end - begin, file->next_id++);
+		ret = lines_append(&new, &inner, 1);
+		if (-1 == ret)
+			goto err_free;
+		begin = end + 1;
+	}
+
+	/*
+	 * The last pasted characters go before the line's right part. Copy it,
+	 * so the line is not changed until all allocations succeed.
+	 */
+	line_init(&tail, file->next_id++);
+	ret = line_append(&tail, begin, last - begin);
+	if (0 == ret)
+		ret = line_append(
+			&tail, &line_chars(line)[pos], line_len_before - pos);
+	if (-1 == ret)
+		goto err_free_tail;
+	ret = lines_append(&new, &tail, 1);
+	if (-1 == ret)
+		goto err_free_tail;
+
+	/* Insert characters before the first line break to the line. */
+	ret = line_ins(line, pos, chars, first_end - chars);
+	if (-1 == ret)
+		goto err_free;
+
+	/* Insert new lines at once. */
+	ret = file_ins_lines(file, idx + 1, lines_at(&new, 0), new.len);
+	if (-1 == ret) {
+		/* Remove inserted characters. Deleting own ones never fails. */
+		while (line_len(line) > line_len_before)
+			line_del_char(line, pos);
+		goto err_free;
+	}
+	lines_free(&new);
+
+	/*
+	 * Insertion may move lines of the page, so get the line again. Its page is
+	 * pinned, so getting it does not load anything and never fails.
+	 */
+	line = file_get_line(file, idx);
+
+	/* Cut the right part, which is moved to the last new line. */
+	line_cut(line, pos + (first_end - chars));
+	file_edit(file, line, pos, first_end - chars, line_len_before - pos, '\0');
+
+	/* Mark file as dirty. */
+	file->is_dirty = 1;
+	return 0;
+err_free_tail:
+	line_free(&tail);
+err_free:
+	while (new.len > 0)
+		line_free(lines_at(&new, --new.len));
+	lines_free(&new);
+	return -1;
+}
+
+char
+file_is_dirty(const struct file *const file)
+{
+	return file->is_dirty;
+}
+
+char
+file_is_loading(const struct file *const file)
+{
+	return NULL != file->loader;
+}
+
+static char
+file_is_mapped(const struct file *const file, const char *const path)
+{
+	int ret;
+	struct stat st;
+
+	if (NULL == file->map)
+		return 0;
+
+	/* File, which does not exist, is definitely not mapped. */
+	ret = stat(path, &st);
+	if (-1 == ret)
+		return 0;
+	return st.st_dev == file->map_dev && st.st_ino == file->map_ino;
+}
+
+int
+file_line(struct file *const file, const size_t idx, struct pub_line *const line)
+{
+	const struct line *internal;
+
+	/* Get internal line struct. */
+	internal = file_get_line(file, idx);
+	if (NULL == internal)
+		return -1;
+
+	/* Copy pointers and values to public line. Own content keeps its gap. */
+	line->chars = line_raw(internal, &line->gap_idx, &line->gap_len);
+	line->len = line_len(internal);
+	line->id = internal->id;
+	line->gen = internal->gen;
+	line->edit = file_line_edit(file, internal);
+	return 0;
+}
+
+static const struct pub_edit*
+file_line_edit(const struct file *const file, const struct line *const line)
+{
+	if (line->id != file->edit_id || line->gen != file->edit_gen)
+		return NULL;
+	return &file->edit;
+}
+
+int
+file_line_flat(
+	struct file *const file, const size_t idx, struct pub_line *const line)
+{
+	struct line *internal;
+
+	/* Get internal line struct. */
+	internal = file_get_line(file, idx);
+	if (NULL == internal)
+		return -1;
+
+	/* Make characters contiguous and copy them to public line. */
+	line->chars = line_chars(internal);
+	line->len = line_len(internal);
+	line->gap_idx = line->len;
+	line->gap_len = 0;
+	line->id = internal->id;
+	line->gen = internal->gen;
+	line->edit = file_line_edit(file, internal);
+	return 0;
+}
+
+
+size_t
+file_lines_cnt(const struct file *const file)
+{
+	return tree_weight(file->pages);
+}
+
+static int
+file_load_bg(
+	struct file *const file, const size_t begin, const size_t threads_cnt)
+{
+	int ret;
+	struct loader *loader;
+
+	/* Allocate loader. */
+	loader = calloc(1, sizeof(*loader));
+	if (NULL == loader)
+		return -1;
+	loader->file = file;
+	loader->begin = begin;
+	loader->threads_cnt = threads_cnt;
+	loader->loaded_len = begin;
+
+	/* Allocate container for loaded pages. */
+	loader->pages = vec_alloc(sizeof(struct page *), &file_pages_policy);
+	if (NULL == loader->pages)
+		goto err_free_loader;
+
+	/* Initialize synchronization primitives. */
+	ret = pthread_mutex_init(&loader->mutex, NULL);
+	if (0 != ret) {
+		errno = ret;
+		goto err_free_loader_and_pages;
+	}
+	ret = pthread_cond_init(&loader->cond, NULL);
+	if (0 != ret) {
+		errno = ret;
+		goto err_destroy_mutex;
+	}
+
+	/* Start loading. */
+	ret = pthread_create(&loader->thread, NULL, loader_run, loader);
+	if (0 != ret) {
+		errno = ret;
+		goto err_destroy_all;
+	}
+	file->loader = loader;
+	return 0;
+err_destroy_all:
+	pthread_cond_destroy(&loader->cond);
+err_destroy_mutex:
+	pthread_mutex_destroy(&loader->mutex);
+err_free_loader_and_pages:
+	vec_free(loader->pages);
+err_free_loader:
+	free(loader);
+	return -1;
+}
+
+static int
+file_load_page(struct file *const file, struct page *const page)
+{
+	int ret;
+
+	/* Remember usage to do not evict the page soon. */
+	page->used = ++file->tick;
+
+	/* Page is already loaded. */
+	if (page->is_loaded)
+		return 0;
+
+	/* Evict unused page to keep the memory usage flat. */
+	if (vec_len(file->cache) >= FILE_PAGES_CACHE_CNT) {
+		ret = file_evict_page(file);
+		if (-1 == ret)
+			return -1;
+	}
+
+	/* Load lines from the mapping. */
+	ret = page_load(page, file->map);
+	if (-1 == ret)
+		return -1;
+
+	/* Remember the page to evict it later. */
+	ret = vec_append(file->cache, &page, 1);
+	if (-1 == ret) {
+		page_unload(page);
+		return -1;
+	}
+	return 0;
+}
+
+size_t
+file_load_pct(const struct file *const file)
+{
+	if (NULL == file->map)
+		return 100;
+	return file->loaded_len * 100 / file->map_len;
+}
+
+static int
+file_map(struct file *const file, const int fd)
+{
+	int ret;
+	struct stat st;
+	void *map;
+
+	/* Get type and size of the file. */
+	ret = fstat(fd, &st);
+	if (-1 == ret)
+		return -1;
+
+	/* Only non-empty regular files can be mapped. */
+	if (!S_ISREG(st.st_mode) || 0 == st.st_size)
+		return 0;
+
+	/* Map the file. Use reading instead if mapping is not supported. */
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (MAP_FAILED == map)
+		return 0;
+
+	/*
+	 * Remember mapping and identity of the mapped file. Keep the descriptor to
+	 * check that the file is not truncated.
+	 */
+	file->map = map;
+	file->map_len = st.st_size;
+	file->map_fd = fd;
+	file->map_dev = st.st_dev;
+	file->map_ino = st.st_ino;
+
+	/* Offsets in the mapping are identities of mapped lines. */
+	file->next_id = file->map_len;
+	return 0;
+}
+
+struct file*
+file_open(const char *const path, const size_t threads_cnt)
+{
+	int ret;
+	int fd;
+	struct file *file;
 
 	/* Allocate opaque struct. */
-	file = file_alloc(path);
+	file = file_alloc(path, threads_cnt);
 	if (NULL == file)
 		return NULL;
 
-	/* Open file using path. */
-	inner_file = fopen(path, "r");
-	if (NULL == inner_file)
-		goto err_free_opaque;
+	/* Open file using path. */
+	fd = open(path, O_RDONLY);
+	if (-1 == fd)
+		goto err_free_opaque;
+
+	/* Try to map the file. */
+	ret = file_map(file, fd);
+	if (-1 == ret)
+		goto err_free_opaque_and_close_fd;
+
+	if (NULL != file->map) {
+		/* Split the mapping to pages. Lines are loaded on demand. */
+		ret = file_index_map(file, threads_cnt);
+		if (-1 == ret)
+			goto err_free_opaque;
+	} else {
+		/* Read lines. */
+		ret = file_read(file, fd);
+		if (-1 == ret)
+			goto err_free_opaque_and_close_fd;
+
+		/* Close opened file. */
+		ret = close(fd);
+		if (-1 == ret)
+			goto err_free_opaque;
+	}
+
+	/* Add empty line if there is no lines. */
+	if (0 == tree_weight(file->pages)) {
+		/* Insert empty line and reset dirty flag. */
+		ret = file_ins_empty_line(file, 0);
+		if (-1 == ret)
+			goto err_free_opaque;
+		file->is_dirty = 0;
+	}
+	return file;
+err_free_opaque_and_close_fd:
+	/* Errors checking is useless here. */
+	close(fd);
+err_free_opaque:
+	file_free(file);
+	return NULL;
+}
+
+const char*
+file_path(const struct file *const file)
+{
+	return file->path;
+}
+
+static int
+file_pin_page(struct file *const file, struct page *const page)
+{
+	int ret;
+	size_t i;
+	struct page *const *const cache = vec_items(file->cache);
+
+	if (page->is_pinned)
+		return 0;
+
+	/* Pinned page must not be evicted, so remove it from cache. */
+	for (i = 0; i < vec_len(file->cache); i++) {
+		if (cache[i] == page) {
+			ret = vec_rm(file->cache, i, NULL);
+			if (-1 == ret)
+				return -1;
+			break;
+		}
+	}
+
+	page->is_pinned = 1;
+	return 0;
+}
+
+static int
+file_read(struct file *const file, const int fd)
+{
+	int ret;
+	char *buf;
+	ssize_t readed;
+	const char *start;
+	const char *end;
+	const char *nl;
+	struct vec *part;
+
+	/* Allocate buffer for blocks. */
+	buf = malloc(FILE_READ_BLOCK_SIZE);
+	if (NULL == buf)
+		return -1;
 
-	/* Read lines. */
-	ret = file_read(file, inner_file);
-	if (-1 == ret)
-		goto err_free_opaque_and_close_file;
+	/* Allocate buffer for the line, which continues in the next block. */
+	part = vec_alloc(sizeof(char), &file_part_policy);
+	if (NULL == part)
+		goto err_free_buf;
 
-	/* Close opened file. */
-	ret = fclose(inner_file);
-	if (EOF == ret)
-		goto err_free_opaque;
+	/* Read blocks until EOF. */
+	while (1) {
+		readed = read(fd, buf, FILE_READ_BLOCK_SIZE);
+		if (-1 == readed && EINTR == errno)
+			continue;
+		if (-1 == readed)
+			goto err_free_buf_and_part;
+		if (0 == readed)
+			break;
 
-	/* Add empty line if there is no lines. */
-	if (vec_len(file->lines) == 0) {
-		/* Insert empty line and reset dirty flag. */
-		ret = file_ins_empty_line(file, 0);
+		/* Split block to lines. */
+		end = buf + readed;
+		for (start = buf; start < end; start = nl + 1) {
+			/* Find end of the line. */
+			nl = str_chr(start, end - start, '\n');
+
+			/* Line continues in the next block. */
+			if (NULL == nl) {
+				ret = vec_append(part, start, end - start);
+				if (-1 == ret)
+					goto err_free_buf_and_part;
+				break;
+			}
+
+			/* Line is finished. Append whole slice at once if possible. */
+			if (0 == vec_len(part)) {
+				ret = file_append_line(file, start, nl - start);
+			} else {
+				ret = vec_append(part, start, nl - start);
+				if (-1 == ret)
+					goto err_free_buf_and_part;
+				ret = file_append_line(file, vec_items(part), vec_len(part));
+				vec_set_len(part, 0);
+			}
+			if (-1 == ret)
+				goto err_free_buf_and_part;
+		}
+	}
+
+	/* Append the last line, which has no '\n' at the end. */
+	if (vec_len(part) > 0) {
+		ret = file_append_line(file, vec_items(part), vec_len(part));
 		if (-1 == ret)
-			goto err_free_opaque;
-		file->is_dirty = 0;
+			goto err_free_buf_and_part;
 	}
-	return file;
-err_free_opaque_and_close_file:
-	/* Errors checking is useless here. */
-	fclose(inner_file);
-err_free_opaque:
-	file_free(file);
-	return NULL;
-}
 
-const char*
-file_path(const struct file *const file)
-{
-	return file->path;
+	vec_free(part);
+	free(buf);
+	return 0;
+err_free_buf_and_part:
+	/* Finished lines are freed with the file. */
+	vec_free(part);
+err_free_buf:
+	free(buf);
+	return -1;
 }
 
 static int
-file_read(struct file *const file, FILE *const inner)
+file_rm_line(struct file *const file, const size_t idx, struct line *const line)
 {
 	int ret;
-	struct line line;
+	size_t pos;
+	size_t first;
+	struct page *page;
 
-	/* Read lines until EOF. */
-	while (1) {
-		/* Read new line. */
-		ret = line_read(&line, inner);
-		if (1 != ret)
-			return ret;
+	/* Get line to pin its page. */
+	if (NULL == file_get_line_to_edit(file, idx))
+		return -1;
+	page = tree_find(file->pages, idx, &pos, &first);
 
-		/* Append readed line. */
-		ret = vec_append(file->lines, &line, 1);
-		if (-1 == ret) {
-			/* Free line which we can't append. */
-			line_free(&line);
-			return -1;
-		}
+	/* Remove the line. */
+	ret = lines_rm(&page->lines, idx - first, line);
+	if (-1 == ret)
+		return -1;
+	page->lines_cnt--;
+	tree_set_weight(file->pages, pos, page->lines_cnt);
+
+	/* Remove empty page. */
+	if (0 == page->lines_cnt) {
+		tree_rm(file->pages, pos);
+		page_free(page);
 	}
+	return 0;
 }
 
 size_t
@@ -488,11 +1703,39 @@ file_save(struct file *const file, const char *const custom_path)
 	size_t len;
 	const char *const path = NULL == custom_path ? file->path : custom_path;
 
+	/* Wait the whole file to do not lose lines, which are not loaded. */
+	ret = file_wait_lines(file, SIZE_MAX);
+	if (-1 == ret)
+		return 0;
+
+	/* Lines must not depend on the mapped file, which is truncated below. */
+	if (file_is_mapped(file, path)) {
+		ret = file_copy_map(file);
+		if (-1 == ret)
+			return 0;
+	}
+
 	/* Try to open file. */
 	inner = fopen(path, "w");
 	if (NULL == inner)
 		return 0;
 
+	/* Write lines to opened file. */
+	len = file_save_to(file, inner);
+	if (0 == len)
+		return 0;
+
+	/* Remove dirty flag because file was saved. */
+	file->is_dirty = 0;
+	return len;
+}
+
+static size_t
+file_save_to(const struct file *const file, FILE *const inner)
+{
+	int ret;
+	size_t len;
+
 	/* Write lines to opened file. */
 	len = file_write(file, inner);
 	if (0 == len)
@@ -507,9 +1750,6 @@ file_save(struct file *const file, const char *const custom_path)
 	ret = fclose(inner);
 	if (EOF == ret)
 		return 0;
-
-	/* Remove dirty flag because file was saved. */
-	file->is_dirty = 0;
 	return len;
 err_close:
 	/* Errors checking here is useless. */
@@ -543,425 +1783,647 @@ file_save_to_spare_dir(struct file *const file, char *const path, size_t len)
 
 int
 file_search_bwd(
-	const struct file *const file,
+	struct file *const file,
 	size_t *const idx,
 	size_t *const pos,
-	const char *const query)
+	const struct search *const search)
 {
 	int ret;
+	size_t first;
+	size_t page_pos;
+	struct page *page;
 	struct line *line;
 
 	/* Try to get initial line. */
-	line = vec_get(file->lines, *idx);
+	line = file_get_line(file, *idx);
 	if (NULL == line)
 		return -1;
 
+	/* Try to search on initial line. */
+	ret = line_search_bwd(line, pos, search);
+	if (ret != 0)
+		return ret;
+
+	page = tree_find(file->pages, *idx, &page_pos, &first);
 	while (1) {
-		/* Try to search on line if not empty. */
-		if (vec_len(line->chars) > 0) {
-			/* Try to search on line. */
-			ret = line_search_bwd(line, pos, query);
-			/* Return if result found or error happened. */
+		/* Search on previous lines of the page. */
+		while (*idx > first) {
+			line = file_get_line(file, --*idx);
+			if (NULL == line)
+				return -1;
+			*pos = line_len(line);
+			ret = line_search_bwd(line, pos, search);
 			if (ret != 0)
 				return ret;
 		}
 
 		/* Break if the start of file reached. */
-		if (0 == *idx)
+		if (0 == page_pos)
 			break;
 
-		/* Move to previous line. */
-		line = vec_get(file->lines, --*idx);
-		if (NULL == line)
-			return -1;
-		/* Continue from the end of previous line. */
-		*pos = vec_len(line->chars);
+		/* Move to previous page. */
+		page = tree_get(file->pages, --page_pos);
+		first -= page->lines_cnt;
+		if (page->is_pinned) {
+			/* Continue from the end of the page's last line. */
+			*idx = first + page->lines_cnt;
+			continue;
+		}
+
+		/* Content of not pinned pages equals to the mapped one. */
+		ret = file_search_pages(file, &page_pos, &first, search, 1, idx, pos);
+		if (ret != 0)
+			return ret;
+		*idx = first;
 	}
 	return 0;
 }
 
 int
 file_search_fwd(
-	const struct file *const file,
+	struct file *const file,
 	size_t *const idx,
 	size_t *const pos,
-	const char *const query)
+	const struct search *const search)
 {
 	int ret;
+	size_t first;
+	size_t page_pos;
+	struct page *page;
 	struct line *line;
 
 	/* Try to get initial line. */
-	line = vec_get(file->lines, *idx);
+	line = file_get_line(file, *idx);
 	if (NULL == line)
 		return -1;
 
+	/* Try to search on initial line. */
+	ret = line_search_fwd(line, pos, search);
+	if (ret != 0)
+		return ret;
+
+	page = tree_find(file->pages, *idx, &page_pos, &first);
 	while (1) {
-		/* Try to search on line if not empty. */
-		if (vec_len(line->chars) > 0) {
-			ret = line_search_fwd(line, pos, query);
-			/* Return if result found or error happened. */
+		/* Search on next lines of the page. */
+		while (*idx + 1 < first + page->lines_cnt) {
+			line = file_get_line(file, ++*idx);
+			if (NULL == line)
+				return -1;
+			*pos = 0;
+			ret = line_search_fwd(line, pos, search);
 			if (ret != 0)
 				return ret;
 		}
 
 		/* Break if the end of file reached. */
-		if (*idx + 1 >= vec_len(file->lines))
+		if (page_pos + 1 >= tree_len(file->pages))
 			break;
 
-		/* Move to next line. */
-		line = vec_get(file->lines, ++*idx);
-		if (NULL == line)
-			return -1;
-		/* Continue from the beginning of the next line. */
-		*pos = 0;
+		/* Move to next page. */
+		first += page->lines_cnt;
+		page = tree_get(file->pages, ++page_pos);
+		if (page->is_pinned) {
+			/* Continue from the beginning of the page's first line. */
+			*idx = first - 1;
+			continue;
+		}
+
+		/* Content of not pinned pages equals to the mapped one. */
+		ret = file_search_pages(file, &page_pos, &first, search, 0, idx, pos);
+		if (ret != 0)
+			return ret;
+		page = tree_get(file->pages, page_pos);
+		*idx = first + page->lines_cnt - 1;
 	}
 	return 0;
 }
 
-static size_t
-file_write(const struct file *const file, FILE *const f)
+static int
+file_search_pages(
+	struct file *const file,
+	size_t *const page_pos,
+	size_t *const first,
+	const struct search *const search,
+	const char is_bwd,
+	size_t *const idx,
+	size_t *const pos)
 {
+	int ret;
 	size_t i;
-	size_t ret;
-	size_t len = 0;
-	const struct line *lines;
+	size_t j;
+	size_t len;
+	size_t jobs_cnt;
+	size_t started;
+	struct page *page;
+	struct page **items;
+	struct vec *pages;
+	struct search_job *jobs;
+	struct search_job *found = NULL;
+	struct search_state state;
+
+	/* Pages are searched in the mapping, so check it first. */
+	ret = file_check_map(file);
+	if (-1 == ret)
+		return -1;
 
-	/* Get lines. */
-	lines = vec_items(file->lines);
+	/* Allocate container for pages in order of searching. */
+	pages = vec_alloc(sizeof(struct page *), &file_pages_policy);
+	if (NULL == pages)
+		return -1;
 
-	/* Write lines and collect written length. */
-	for (i = 0; i < vec_len(file->lines); i++) {
-		ret = line_write(&lines[i], f);
-		if (0 == ret)
-			return 0;
-		len += ret;
+	/* Collect not pinned pages until chunks of all threads are filled. */
+	for (i = *page_pos, len = 0;; i = is_bwd ? i - 1 : i + 1) {
+		page = tree_get(file->pages, i);
+		if (page->is_pinned)
+			break;
+		ret = vec_append(pages, &page, 1);
+		if (-1 == ret)
+			goto err_free_pages;
+		len += page->len;
+		if (len >= FILE_SEARCH_CHUNK_SIZE * file->threads_cnt)
+			break;
+		if (is_bwd ? 0 == i : i + 1 >= tree_len(file->pages))
+			break;
+	}
+	items = vec_items(pages);
+
+	/* Allocate jobs. Each job searches at least one page. */
+	jobs_cnt = MIN(file->threads_cnt, vec_len(pages));
+	jobs = calloc(jobs_cnt, sizeof(*jobs));
+	if (NULL == jobs)
+		goto err_free_pages;
+
+	/* Initialize state shared by jobs. */
+	state.found_job = SIZE_MAX;
+	ret = pthread_mutex_init(&state.mutex, NULL);
+	if (0 != ret) {
+		errno = ret;
+		goto err_free_pages_and_jobs;
 	}
-	return len;
-}
 
-static int
-line_append(struct line *const line, const char *const chars, const size_t len)
-{
-	int ret;
+	/* Split pages to ranges of equal count. Nearer pages go to lower jobs. */
+	for (i = 0; i < jobs_cnt; i++) {
+		jobs[i].map = file->map;
+		jobs[i].search = search;
+		jobs[i].pages = &items[vec_len(pages) * i / jobs_cnt];
+		jobs[i].pages_cnt = &items[vec_len(pages) * (i + 1) / jobs_cnt]
+			- jobs[i].pages;
+		jobs[i].is_bwd = is_bwd;
+		jobs[i].idx = i;
+		jobs[i].state = &state;
+	}
 
-	/* Copy chars to line. */
-	ret = vec_append(line->chars, chars, len);
-	if (-1 == ret)
-		return -1;
+	/* Search in the current thread if there is nothing to split. */
+	if (1 == jobs_cnt) {
+		search_job_run(&jobs[0]);
+		started = 1;
+	} else {
+		for (started = 0; started < jobs_cnt; started++) {
+			ret = pthread_create(
+				&jobs[started].thread, NULL, search_job_run, &jobs[started]);
+			if (0 != ret)
+				break;
+		}
+
+		/* Cancel started jobs if a thread can not be created. */
+		if (started < jobs_cnt) {
+			pthread_mutex_lock(&state.mutex);
+			state.found_job = 0;
+			pthread_mutex_unlock(&state.mutex);
+		}
+		for (i = 0; i < started; i++)
+			pthread_join(jobs[i].thread, NULL);
+		if (started < jobs_cnt) {
+			errno = ret;
+			goto err_destroy_mutex;
+		}
+	}
+
+	/* The nearest job, which found result, is never canceled. */
+	for (i = 0; i < jobs_cnt && NULL == found; i++)
+		if (NULL != jobs[i].found)
+			found = &jobs[i];
+
+	/* Move to the page with result or to the last searched page. */
+	i = NULL == found
+		? vec_len(pages) - 1
+		: (size_t)(found->pages - items) + found->found_page;
+	for (j = 0; j < i; j++) {
+		if (is_bwd) {
+			--*page_pos;
+			*first -= items[j + 1]->lines_cnt;
+		} else {
+			++*page_pos;
+			*first += items[j]->lines_cnt;
+		}
+	}
+
+	/* Find line of the result. */
+	ret = 0;
+	if (NULL != found) {
+		*idx = *first;
+		page_find(items[i], file->map, found->found, idx, pos);
+		ret = 1;
+	}
 
-	/* Render line with new chars. */
-	ret = line_render(line);
+	pthread_mutex_destroy(&state.mutex);
+	free(jobs);
+	vec_free(pages);
 	return ret;
+err_destroy_mutex:
+	pthread_mutex_destroy(&state.mutex);
+err_free_pages_and_jobs:
+	free(jobs);
+err_free_pages:
+	vec_free(pages);
+	return -1;
 }
 
-int
-line_break(struct line *const line, const size_t idx, struct line *const new)
+static int
+file_split_page(struct file *const file, const size_t pos)
 {
 	int ret;
-	size_t new_len;
-	const char *new_chars;
-
-	/* Initialize new line. */
-	ret = line_init(new);
-	if (-1 == ret)
-		return -1;
+	size_t cnt;
+	struct page *new;
+	struct page *const page = tree_get(file->pages, pos);
 
-	/* Get new line length. */
-	new_len = vec_len(line->chars) - idx;
+	/* Page is not too big. */
+	if (page->lines_cnt <= FILE_PAGE_MAX_LINES_CNT)
+		return 0;
 
-	/* Copy characters from broken line to new line if its length is not zero. */
-	if (new_len > 0) {
-		/* Get start of part which we need to move to new line. */
-		new_chars = vec_get(line->chars, idx);
-		if (NULL == new_chars)
-			goto err_free;
+	/* Move the last lines to new pages. Many lines are inserted by pasting. */
+	while (page->lines_cnt > FILE_PAGE_MAX_LINES_CNT) {
+		/* Allocate page for the last lines. */
+		new = page_alloc_pinned();
+		if (NULL == new)
+			return -1;
 
-		/* Append broken chars to new line. */
-		ret = line_append(new, new_chars, new_len);
+		/* Copy the last lines to the new page. */
+		cnt = MIN(FILE_PAGE_LINES_CNT, page->lines_cnt - FILE_PAGE_LINES_CNT);
+		ret = lines_append(
+			&new->lines, lines_at(&page->lines, page->lines_cnt - cnt), cnt);
 		if (-1 == ret)
 			goto err_free;
+		new->lines_cnt = cnt;
 
-		/* Cut broken line. */
-		ret = line_cut(line, idx);
+		/* Insert new page after the split one. */
+		ret = tree_ins(file->pages, pos + 1, new, new->lines_cnt);
 		if (-1 == ret)
 			goto err_free;
+
+		/* Leave only the first lines in the split page. Lines are moved. */
+		page->lines.len -= cnt;
+		page->lines_cnt -= cnt;
+		tree_set_weight(file->pages, pos, page->lines_cnt);
 	}
+	lines_shrink(&page->lines);
 	return 0;
 err_free:
-	line_free(new);
+	/* Lines are still owned by the split page, so do not free them. */
+	lines_free(&new->lines);
+	free(new);
+	lines_shrink(&page->lines);
 	return -1;
 }
 
-static size_t
-line_calc_render_cap(struct line *const line)
+static void
+file_stop_loading(struct file *const file)
 {
-	size_t i;
-	size_t len = 0;
-	const char *chars;
-
-	chars = vec_items(line->chars);
-	for (i = 0; i < vec_len(line->chars); i++)
-		len += str_exp(chars[i], len);
-	return len;
+	struct loader *const loader = file->loader;
+
+	if (NULL == loader)
+		return;
+
+	/* Ask the thread to stop and wait it. */
+	pthread_mutex_lock(&loader->mutex);
+	loader->is_canceled = 1;
+	pthread_mutex_unlock(&loader->mutex);
+	pthread_join(loader->thread, NULL);
+
+	/* Free pages, which were not taken, and the loader. */
+	file_free_pages(loader->pages);
+	pthread_cond_destroy(&loader->cond);
+	pthread_mutex_destroy(&loader->mutex);
+	free(loader);
+	file->loader = NULL;
 }
 
-static int
-line_cut(struct line *const line, const size_t len)
+int
+file_wait_lines(struct file *const file, const size_t cnt)
 {
 	int ret;
+	int err;
+	size_t lines_cnt;
+	char is_done;
+	struct loader *const loader = file->loader;
 
-	/* Update broken line's length. */
-	ret = vec_set_len(line->chars, len);
-	if (-1 == ret)
-		return -1;
+	/* File is already loaded. */
+	if (NULL == loader)
+		return 0;
 
-	/* Shrink broken line's capacity if needed. */
-	ret = vec_shrink_if_needed(line->chars);
+	/* Wait until enough lines are loaded. */
+	pthread_mutex_lock(&loader->mutex);
+	while (
+		!loader->is_done
+		&& tree_weight(file->pages) + loader->lines_cnt < cnt
+	)
+		pthread_cond_wait(&loader->cond, &loader->mutex);
+
+	/* Take loaded pages. */
+	lines_cnt = tree_weight(file->pages);
+	ret = file_append_pages(file, loader->pages);
+	loader->lines_cnt -= tree_weight(file->pages) - lines_cnt;
+	if (0 == ret)
+		file->loaded_len = loader->loaded_len;
+	is_done = loader->is_done;
+	err = loader->err;
+	pthread_mutex_unlock(&loader->mutex);
 	if (-1 == ret)
 		return -1;
 
-	/* Render line with new length. */
-	ret = line_render(line);
-	return ret;
+	/* Free the loader after the last pages are taken. */
+	if (is_done) {
+		file_stop_loading(file);
+		if (0 != err) {
+			errno = err;
+			return -1;
+		}
+	}
+	return 0;
 }
 
-int
-line_del_char(struct line *const line, const size_t idx)
+static size_t
+file_write(const struct file *const file, FILE *const f)
 {
-	int ret;
-
-	/* Remove character. */
-	ret = vec_rm(line->chars, idx, NULL);
-	if (-1 == ret)
-		return -1;
+	int checked;
+	size_t i;
+	size_t ret;
+	size_t len = 0;
 
-	/* Rerender updated line. */
-	ret = line_render(line);
-	return ret;
-}
+	/* Not pinned pages are written from the mapping, so check it first. */
+	checked = file_check_map(file);
+	if (-1 == checked)
+		return 0;
 
-void
-line_free(struct line *const line)
-{
-	/* Free raw chars and render. */
-	vec_free(line->chars);
-	free(line->render);
+	/* Write pages and collect written length. */
+	for (i = 0; i < tree_len(file->pages); i++) {
+		ret = page_write(tree_get(file->pages, i), file->map, f);
+		if (0 == ret)
+			return 0;
+		len += ret;
+	}
+	return len;
 }
 
-static int
-line_init(struct line *const line)
+static void*
+index_job_run(void *const arg)
 {
-	/* Allocate characters container. */
-	line->chars = vec_alloc(sizeof(char), LINE_CHARS_CAP_STEP);
-	if (NULL == line->chars)
-		return -1;
+	struct index_job *const job = arg;
 
-	/* Initialize render fields. */
-	line->render = NULL;
-	line->render_len = 0;
-	return 0;
+	/* Index pages and save error number for the joining thread. */
+	job->ret = file_index_range(job->file, job->begin, job->end, job->pages);
+	job->err = errno;
+	return NULL;
 }
 
-int
-line_ins_char(struct line *const line, const size_t idx, const char ch)
+static void*
+loader_run(void *const arg)
 {
-	int ret;
-
-	/* Insert character to line. */
-	ret = vec_ins(line->chars, idx, &ch, 1);
-	if (-1 == ret)
-		return -1;
-
-	/* Rerender line after character insertion. */
-	ret = line_render(line);
-	return ret;
-}
+	int ret = 0;
+	int err = 0;
+	size_t i;
+	size_t begin;
+	size_t end;
+	size_t lines_cnt;
+	char is_canceled = 0;
+	struct vec *pages;
+	struct page **items;
+	struct loader *const loader = arg;
+	const struct file *const file = loader->file;
+
+	/* Allocate container for pages of the chunk. */
+	pages = vec_alloc(sizeof(struct page *), &file_pages_policy);
+	if (NULL == pages) {
+		err = errno;
+		goto done;
+	}
 
+	for (begin = loader->begin; begin < file->map_len && !is_canceled; begin = end) {
+		/* Do not read the mapping if the file is truncated. */
+		ret = file_check_map(file);
+		if (-1 == ret)
+			break;
 
-static int
-line_read(struct line *const line, FILE *const f)
-{
-	int ret;
-	int ch;
+		/* Index the next chunk using all threads. */
+		end = MIN(file->map_len, begin + FILE_LOAD_CHUNK_SIZE * loader->threads_cnt);
+		if (loader->threads_cnt > 1)
+			ret = file_index_map_par(file, begin, end, loader->threads_cnt, pages);
+		else
+			ret = file_index_range(file, begin, end, pages);
+		if (-1 == ret)
+			break;
 
-	/* Initialize empty line to in which to read. */
-	ret = line_init(line);
-	if (-1 == ret)
-		return -1;
+		/* Count lines of the chunk. */
+		items = vec_items(pages);
+		for (i = 0, lines_cnt = 0; i < vec_len(pages); i++)
+			lines_cnt += items[i]->lines_cnt;
 
-	/* Read characters. */
-	while (1) {
-		/* Try to read character. */
-		ch = fgetc(f);
-		if (ferror(f) != 0)
-			goto err;
-
-		/* First character is EOF. So there is no more lines. */
-		if (vec_len(line->chars) == 0 && EOF == ch) {
-			/* Free unused line. */
-			line_free(line);
-			return 0;
+		/* Pass pages to the file and wake up the waiting file. */
+		pthread_mutex_lock(&loader->mutex);
+		ret = vec_append(loader->pages, items, vec_len(pages));
+		if (0 == ret) {
+			loader->lines_cnt += lines_cnt;
+			loader->loaded_len = end;
+			pthread_cond_broadcast(&loader->cond);
 		}
-
-		/* Check end of line reached. */
-		if ('\n' == ch)
+		is_canceled = loader->is_canceled;
+		pthread_mutex_unlock(&loader->mutex);
+		if (-1 == ret)
 			break;
 
-		/* Append readed character. */
-		ret = vec_append(line->chars, &ch, 1);
-		if (-1 == ret)
-			goto err;
+		/* Pages are passed to the file, so forget them. */
+		vec_set_len(pages, 0);
 	}
-
-	/* Render readed line. */
-	ret = line_render(line);
 	if (-1 == ret)
-		goto err;
-	return 1;
-err:
-	line_free(line);
-	return -1;
+		err = errno;
+
+	/* Free pages, which were not passed to the file. */
+	file_free_pages(pages);
+done:
+	/* Notify the file that loading is done. */
+	pthread_mutex_lock(&loader->mutex);
+	loader->is_done = 1;
+	loader->err = err;
+	pthread_cond_broadcast(&loader->cond);
+	pthread_mutex_unlock(&loader->mutex);
+	return NULL;
 }
 
-static int
-line_render(struct line *const line)
+static struct page*
+page_alloc_pinned(void)
 {
-	size_t render_cap;
+	struct page *page;
 
-	/* Free old render. */
-	free(line->render);
-	line->render = NULL;
-	line->render_len = 0;
+	/* Allocate page with zeroed fields. */
+	page = calloc(1, sizeof(*page));
+	if (NULL == page)
+		return NULL;
 
-	/* Get new render's capacity. */
-	render_cap = line_calc_render_cap(line);
-	if (0 == render_cap)
-		return 0;
+	/* There is no mapped content to load lines again. */
+	lines_init(&page->lines);
+	page->is_loaded = 1;
+	page->is_pinned = 1;
+	return page;
+}
 
-	/* Allocate render buffer. */
-	line->render = malloc(render_cap);
-	if (NULL == line->render)
-		return -1;
+static void
+page_find(
+	const struct page *const page,
+	const char *const map,
+	const char *const found,
+	size_t *const idx,
+	size_t *const pos
+) {
+	const char *start = &map[page->off];
+	const char *nl;
 
-	/* Render line after buffer allocation. */
-	line_render_no_alloc(line);
-	return 0;
+	/* Count lines before the found characters. */
+	while (NULL != (nl = str_chr(start, found - start, '\n'))) {
+		++*idx;
+		start = nl + 1;
+	}
+	*pos = found - start;
 }
 
 static void
-line_render_no_alloc(struct line *const line)
+page_free(struct page *const page)
 {
-	size_t i;
-	const char *chars;
-	chars = vec_items(line->chars);
-
-	line->render_len = 0;
-	for (i = 0; i < vec_len(line->chars); i++) {
-		if ('\t' == chars[i]) {
-			/* Expand tab with spaces. */
-			line->render[line->render_len++] = ' ';
-			while (line->render_len % CFG_TAB_SIZE != 0)
-				line->render[line->render_len++] = ' ';
-		} else {
-			/* Render simple character. */
-			line->render[line->render_len++] = chars[i];
-		}
-	}
+	page_unload(page);
+	free(page);
 }
 
 static int
-line_search_bwd(
-	const struct line *const line,
-	size_t *const idx,
-	const char *const query
-) {
+page_load(struct page *const page, const char *const map)
+{
 	int ret;
-	const char *start;
-	const char *ptr;
-	size_t query_len;
+	struct line line;
+	const char *start = &map[page->off];
+	const char *const end = &map[page->off + page->len];
+	const char *nl;
+
+	/* Allocate lines container. Count of lines is known from indexing. */
+	lines_init(&page->lines);
+	page->is_loaded = 1;
+	ret = lines_reserve(&page->lines, page->lines_cnt);
+	if (-1 == ret)
+		goto err_unload;
 
-	/* Validate accepted index. */
-	if (*idx > vec_len(line->chars)) {
-		errno = EINVAL;
-		return -1;
-	}
+	while (start < end) {
+		/* Find end of the line. The last line may have no '\n'. */
+		nl = str_chr(start, end - start, '\n');
+		if (NULL == nl)
+			nl = end;
 
-	/* Validate query length. */
-	query_len = strlen(query);
-	if (0 == query_len)
-		return 0;
+		/* Map line. Its offset is the identity stable across reloading. */
+		line_map(&line, start, nl - start, start - map);
 
-	start = vec_items(line->chars);
+		/* Append created line. */
+		ret = lines_append(&page->lines, &line, 1);
+		if (-1 == ret)
+			goto err_unload;
 
-	for (ptr = start + *idx - query_len; ptr >= start; ptr--) {
-		/* Compare current shifted part with needle. */
-		ret = strncmp(ptr, query, query_len);
-		if (0 == ret) {
-			/* Set result. */
-			*idx = ptr - start;
-			return 1;
-		}
+		/* Move to the beginning of the next line. */
+		start = nl + 1;
 	}
 	return 0;
+err_unload:
+	page_unload(page);
+	return -1;
 }
 
-static int
-line_search_fwd(
-	const struct line *const line, size_t *const idx, const char *const query)
+static void
+page_unload(struct page *const page)
 {
-	int ret;
-	size_t search_len;
-	const char *start;
-	const char *ptr;
-	size_t query_len;
-
-	/* Get start of search. */
-	start = vec_get(line->chars, *idx);
-	if (NULL == start)
-		return -1;
-
-	/* Get length of substring. */
-	search_len = vec_len(line->chars) - *idx;
+	size_t i;
 
-	/* Validate query length. */
-	query_len = strlen(query);
-	if (search_len < query_len)
-		return 0;
-	if (0 == query_len)
-		return 0;
+	/* Page is not loaded. */
+	if (!page->is_loaded)
+		return;
 
-	for (ptr = start; ptr < start + search_len; ptr++) {
-		/* Compare current shifted part with query. */
-		ret = strncmp(ptr, query, query_len);
-		if (0 == ret) {
-			/* Set result. */
-			*idx = ptr - start;
-			return 1;
-		}
-	}
-	return 0;
+	/* Free lines. */
+	for (i = 0; i < page->lines.len; i++)
+		line_free(lines_at(&page->lines, i));
+	lines_free(&page->lines);
+	page->is_loaded = 0;
 }
 
 static size_t
-line_write(const struct line *const line, FILE *const f)
+page_write(const struct page *const page, const char *const map, FILE *const f)
 {
 	int ret;
+	size_t i;
 	size_t len;
 	size_t written;
 
-	/* Write line characters to the file. */
-	len = vec_len(line->chars);
-	written = fwrite(vec_items(line->chars), sizeof(char), len, f);
+	/* Content of not pinned page equals to the mapped one. */
+	if (!page->is_pinned) {
+		written = fwrite(&map[page->off], sizeof(char), page->len, f);
+		if (written != page->len)
+			return 0;
 
-	/* Check write error. */
-	if (written != len)
-		return 0;
+		/* Append newline if the last line of the file has no it. */
+		if ('\n' != map[page->off + page->len - 1]) {
+			ret = fputc('\n', f);
+			if (EOF == ret)
+				return 0;
+			written++;
+		}
+		return written;
+	}
 
-	/* Append newline to the end. */
-	ret = fputc('\n', f);
-	if (EOF == ret)
-		return 0;
+	/* Write lines and collect written length. */
+	for (i = 0, written = 0; i < page->lines.len; i++) {
+		len = line_write(lines_at(&page->lines, i), f);
+		if (0 == len)
+			return 0;
+		written += len;
+	}
+	return written;
+}
+
+static void*
+search_job_run(void *const arg)
+{
+	size_t i;
+	size_t found_job;
+	const struct page *page;
+	struct search_job *const job = arg;
+	struct search_state *const state = job->state;
+
+	job->found = NULL;
+	for (i = 0; i < job->pages_cnt; i++) {
+		/* Stop if a nearer job found result. */
+		pthread_mutex_lock(&state->mutex);
+		found_job = state->found_job;
+		pthread_mutex_unlock(&state->mutex);
+		if (found_job < job->idx)
+			break;
 
-	/* Return written length. Do not forget about newline character. */
-	return written + 1;
+		/* Search the mapped content of the page. */
+		page = job->pages[i];
+		job->found = job->is_bwd
+			? search_bwd(job->search, &job->map[page->off], page->len)
+			: search_fwd(job->search, &job->map[page->off], page->len);
+		if (NULL == job->found)
+			continue;
+
+		/* Cancel farther jobs. */
+		job->found_page = i;
+		pthread_mutex_lock(&state->mutex);
+		if (job->idx < state->found_job)
+			state->found_job = job->idx;
+		pthread_mutex_unlock(&state->mutex);
+		break;
+	}
+	return NULL;
 }
@@ -2,19 +2,34 @@
 #define _FILE_H
 
 #include <stddef.h>
+#include "search.h"
 
 /* Opaque struct of opened file. */
 struct file;
 
+/*
+ * Edit, which made the line's generation from the previous one. Inserted
+ * characters start at the index. Removed characters started at the index.
+ */
+struct pub_edit {
+	size_t idx; /* Index of the edit. */
+	size_t ins_len; /* Count of inserted characters. */
+	size_t del_len; /* Count of removed characters. */
+	char del_ch; /* Removed character if only one is removed. */
+};
+
 /*
  * Read only line data. Use functions to modify a string instead of modifying
  * this structure.
  */
 struct pub_line {
-	const char *chars;
-	size_t len;
-	const char *render;
-	size_t render_len;
+	const char *chars; /* Raw characters. May contain the gap. */
+	size_t len; /* Length of raw characters without the gap. */
+	size_t gap_idx; /* Index of the gap in raw characters. */
+	size_t gap_len; /* Length of the gap. Zero if characters are contiguous. */
+	size_t id; /* Identity. Unique among lines of the file. */
+	size_t gen; /* Edit generation. Changes after every edit of the line. */
+	const struct pub_edit *edit; /* Edit, which made the generation, or `NULL`. */
 };
 
 /*
@@ -77,32 +92,66 @@ int file_ins_char(struct file *, size_t, size_t, char);
  */
 int file_ins_empty_line(struct file *, size_t);
 
+/*
+ * Inserts passed characters to the file's line at passed position. Characters
+ * are split into lines by `'\n'` at once.
+ *
+ * Returns 0 on success and -1 on error.
+ *
+ * Sets `EINVAL` if line not found or insertion position is invalid.
+ */
+int file_ins_str(struct file *, size_t, size_t, const char *, size_t);
+
 /*
  * Checks that file is dirty.
  */
 char file_is_dirty(const struct file *);
 
 /*
- * Finds line by passed index and returns its data.
+ * Checks that the rest of file is still loading in background.
+ */
+char file_is_loading(const struct file *);
+
+/*
+ * Finds line by passed index and returns its data. Lines are loaded on demand,
+ * so pointers of returned data may become invalid after getting of other lines.
+ *
+ * Returns 0 on success and -1 on error.
+ *
+ * Sets `EINVAL` if index is invalid.
+ */
+int file_line(struct file *, size_t, struct pub_line *);
+
+/*
+ * Does the same as `file_line`, but makes raw characters contiguous. Use it
+ * only when contiguous characters are really needed.
  *
  * Returns 0 on success and -1 on error.
  *
  * Sets `EINVAL` if index is invalid.
  */
-int file_line(const struct file *, size_t, struct pub_line *);
+int file_line_flat(struct file *, size_t, struct pub_line *);
 
 /*
  * Returns lines count of opened file.
  */
 size_t file_lines_cnt(const struct file *);
 
+/*
+ * Returns percentage of loaded file's content.
+ */
+size_t file_load_pct(const struct file *);
+
 /*
  * Reads the contents of file. Adds an empty line if there are no lines in the
  * file. Do not forget to close file.
  *
+ * Only the beginning of big file is loaded here. The rest is loaded in
+ * background using passed count of threads, see `file_wait_lines`.
+ *
  * Returns pointer to opaque struct on success or `NULL` on error.
  */
-struct file *file_open(const char *);
+struct file *file_open(const char *, size_t);
 
 /*
  * Gets path of opened file.
@@ -128,21 +177,32 @@ size_t file_save(struct file *, const char *);
 size_t file_save_to_spare_dir(struct file *, char *, size_t);
 
 /*
- * Searches backward from passed position to start of file.
+ * Searches backward from passed position to start of file. Not edited pages
+ * are searched at once, so the query must not contain `'\n'`.
  *
  * Returns 1 if result found, 0 if no result and -1 on error.
  *
  * Sets `EINVAL` if index or position is invalid.
  */
-int file_search_bwd(const struct file *, size_t *, size_t *, const char *);
+int file_search_bwd(struct file *, size_t *, size_t *, const struct search *);
 
 /*
- * Searches forward from passed position to end of file.
+ * Searches forward from passed position to end of file. Not edited pages
+ * are searched at once, so the query must not contain `'\n'`.
  *
  * Returns 1 if result found, 0 if no result and -1 on error.
  *
  * Sets `EINVAL` if index or position is invalid.
  */
-int file_search_fwd(const struct file *, size_t *, size_t *, const char *);
+int file_search_fwd(struct file *, size_t *, size_t *, const struct search *);
+
+/*
+ * Waits until passed count of lines is loaded or the whole file is loaded and
+ * takes lines loaded in background. Pass 0 to take loaded lines without
+ * waiting or `SIZE_MAX` to wait the whole file.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int file_wait_lines(struct file *, size_t);
 
 #endif /* _FILE_H */
@@ -0,0 +1,193 @@
+#include <stdlib.h>
+#include "cfg.h"
+#include "input.h"
+#include "term.h"
+
+enum {
+	INPUT_CAP = 4096, /* Capacity of the ring of read characters. */
+	INPUT_ESC = 27, /* The first character of escape sequences. */
+};
+
+/*
+ * Ring buffer of terminal input.
+ */
+struct input {
+	char items[INPUT_CAP]; /* Ring of read characters. */
+	size_t begin; /* Index of the first not processed character. */
+	size_t len; /* Count of not processed characters. */
+};
+
+/*
+ * Gets not processed character by its index from the beginning.
+ */
+static char input_at(const struct input *, size_t);
+
+/*
+ * Reads available input to free space after not processed characters with
+ * one system call. Waits for input if there is no available input.
+ *
+ * Returns count of read characters on success and -1 on error.
+ */
+static int input_fill(struct input *);
+
+/*
+ * Gets length of the key at the beginning of not processed characters.
+ * Escape sequences are control sequences (`ESC [`), mouse reports
+ * (`ESC [ M` and three characters) and single shifts (`ESC O` and one
+ * character). Escape followed by other character is a separate key.
+ *
+ * Returns length of the key or 0 if the key is incomplete.
+ */
+static size_t input_key_len(const struct input *);
+
+struct input*
+input_alloc(void)
+{
+	struct input *input;
+
+	/* Allocate opaque struct with the ring. */
+	input = malloc(sizeof(*input));
+	if (NULL == input)
+		return NULL;
+	input->begin = 0;
+	input->len = 0;
+	return input;
+}
+
+static char
+input_at(const struct input *const input, const size_t idx)
+{
+	return input->items[(input->begin + idx) % INPUT_CAP];
+}
+
+static int
+input_fill(struct input *const input)
+{
+	ssize_t readed;
+	size_t free_len;
+	const size_t end = (input->begin + input->len) % INPUT_CAP;
+
+	/* Get contiguous free space after not processed characters. */
+	if (INPUT_CAP == input->len)
+		return 0;
+	free_len = end < input->begin ? input->begin - end : INPUT_CAP - end;
+
+	/* Read available input to free space. */
+	readed = term_read(&input->items[end], free_len);
+	if (-1 == readed)
+		return -1;
+	input->len += readed;
+	return readed;
+}
+
+void
+input_free(struct input *const input)
+{
+	free(input);
+}
+
+char
+input_is_empty(const struct input *const input)
+{
+	return 0 == input->len;
+}
+
+static size_t
+input_key_len(const struct input *const input)
+{
+	size_t i;
+	char ch;
+
+	/* Check that the key is an escape sequence. */
+	if (0 == input->len)
+		return 0;
+	if (INPUT_ESC != input_at(input, 0))
+		return 1;
+	if (input->len < 2)
+		return 0;
+
+	/* Check kind of escape sequence. */
+	switch (input_at(input, 1)) {
+	case '[':
+		break;
+	case 'O':
+		return input->len < 3 ? 0 : 3;
+	default:
+		return 1;
+	}
+	if (input->len < 3)
+		return 0;
+	if ('M' == input_at(input, 2))
+		return input->len < 6 ? 0 : 6;
+
+	/* Control sequence ends with final character. */
+	for (i = 2; i < input->len && i < INPUT_KEY_MAX_LEN; i++) {
+		ch = input_at(input, i);
+		if (ch >= 0x40 && ch <= 0x7e)
+			return i + 1;
+		/* Sequence is broken before not parameter and not intermediate one. */
+		if (ch < 0x20 || ch > 0x3f)
+			return i;
+	}
+	return INPUT_KEY_MAX_LEN == i ? i : 0;
+}
+
+int
+input_next(struct input *const input, char *const key, size_t *const len)
+{
+	int ret;
+	size_t i;
+	size_t key_len;
+
+	/* Wait for the rest of incomplete escape sequence. */
+	key_len = input_key_len(input);
+	if (0 == key_len && input->len > 0) {
+		ret = term_wait_input(CFG_ESC_TIMEOUT_MS);
+		if (-1 == ret)
+			return -1;
+		if (1 == ret && -1 == input_fill(input))
+			return -1;
+
+		/* Split incomplete sequence as is if there is no rest. */
+		key_len = input_key_len(input);
+		if (0 == key_len)
+			key_len = input->len;
+	}
+	if (0 == key_len)
+		return 0;
+
+	/* Take the key from the ring. */
+	for (i = 0; i < key_len; i++)
+		key[i] = input_at(input, i);
+	*len = key_len;
+	input->begin = (input->begin + key_len) % INPUT_CAP;
+	input->len -= key_len;
+	return 1;
+}
+
+int
+input_read(struct input *const input)
+{
+	int ret;
+
+	/*
+	 * Wait for input if there is nothing to process. Return on interruption to
+	 * process signals before keys.
+	 */
+	if (0 == input->len) {
+		ret = input_fill(input);
+		if (ret <= 0)
+			return ret;
+	}
+
+	/* Read the rest of available input while there is space. */
+	while (input->len < INPUT_CAP) {
+		ret = term_wait_input(0);
+		if (1 != ret)
+			return ret;
+		ret = input_fill(input);
+		if (ret <= 0)
+			return ret;
+	}
+	return 0;
+}
@@ -0,0 +1,51 @@
+#ifndef _INPUT_H
+#define _INPUT_H
+
+#include <stddef.h>
+
+enum {
+	INPUT_KEY_MAX_LEN = 32, /* Max length of a key. Longer ones are split. */
+};
+
+/*
+ * Opaque ring buffer of terminal input. Input is read at once and split into
+ * keys and escape sequences.
+ */
+struct input;
+
+/*
+ * Allocates empty input. Do not forget to free it.
+ *
+ * Returns pointer to opaque input on success and `NULL` on error.
+ */
+struct input *input_alloc(void);
+
+/*
+ * Frees allocated input.
+ */
+void input_free(struct input *);
+
+/*
+ * Checks that there is no read input.
+ */
+char input_is_empty(const struct input *);
+
+/*
+ * Gets the next key from read input. Writes the key to passed buffer, which
+ * must fit `INPUT_KEY_MAX_LEN` characters, and its length by passed pointer.
+ * If the rest of input is an incomplete escape sequence, then waits up to
+ * `CFG_ESC_TIMEOUT_MS` for its end. Incomplete sequence is split as is.
+ *
+ * Returns 1 if key is got, 0 if there are no more keys and -1 on error.
+ */
+int input_next(struct input *, char *, size_t *);
+
+/*
+ * Reads all available input while there is space. Waits for input if there
+ * is no read input. Reads nothing if waiting is interrupted by a signal.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int input_read(struct input *);
+
+#endif /* _INPUT_H */
@@ -0,0 +1,454 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "line.h"
+#include "math.h"
+
+/*
+ * Gets buffer of own characters with the gap.
+ */
+static char *line_buf(struct line *);
+
+/*
+ * Grows the gap of own characters to passed length if it is shorter.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+static int line_grow_gap(struct line *, size_t);
+
+/*
+ * Moves the gap of own characters to passed index.
+ */
+static void line_mv_gap(struct line *, size_t);
+
+/*
+ * Copies mapped content to the own buffer if not copied yet. Use it before
+ * characters modification.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+static int line_own(struct line *);
+
+int
+line_append(struct line *const line, const char *const chars, const size_t len)
+{
+	int ret;
+
+	/* Make sure that line has own characters. */
+	ret = line_own(line);
+	if (-1 == ret)
+		return -1;
+
+	/* Make space at the end of the line. */
+	line_mv_gap(line, line->len);
+	ret = line_grow_gap(line, len);
+	if (-1 == ret)
+		return -1;
+
+	/* Copy chars to the gap. */
+	memcpy(&line_buf(line)[line->gap_idx], chars, len);
+	line->gap_idx += len;
+	line->len += len;
+	line->gen++;
+	return 0;
+}
+
+int
+line_break(
+	struct line *const line,
+	const size_t idx,
+	struct line *const new,
+	const size_t id)
+{
+	int ret;
+	size_t new_len;
+	const char *new_chars;
+
+	/* Validate index. */
+	if (idx > line->len) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Initialize new line. */
+	line_init(new, id);
+
+	/* Get new line length. */
+	new_len = line->len - idx;
+
+	/* Copy characters from broken line to new line if its length is not zero. */
+	if (new_len > 0) {
+		/* Get start of part which we need to move to new line. */
+		if (0 == line->cap) {
+			new_chars = &line->raw.mapped[idx];
+		} else {
+			/* Characters after the gap are contiguous. */
+			line_mv_gap(line, idx);
+			new_chars = &line_buf(line)[line->cap - new_len];
+		}
+
+		/* Append broken chars to new line. */
+		ret = line_append(new, new_chars, new_len);
+		if (-1 == ret) {
+			line_free(new);
+			return -1;
+		}
+
+		/* Cut broken line. */
+		line_cut(line, idx);
+	}
+	return 0;
+}
+
+static char*
+line_buf(struct line *const line)
+{
+	return line->cap > LINE_INLINE_CAP ? line->raw.chars : line->raw.inl;
+}
+
+const char*
+line_chars(struct line *const line)
+{
+	if (0 == line->cap)
+		return line->raw.mapped;
+
+	/* Move the gap to the end to make characters contiguous. */
+	line_mv_gap(line, line->len);
+	return line_buf(line);
+}
+
+void
+line_cut(struct line *const line, const size_t len)
+{
+	char *chars;
+	size_t cap;
+
+	/* Mapped content is not copied. Just cut it. */
+	line->gen++;
+	if (0 == line->cap) {
+		line->len = MIN(line->len, len);
+		return;
+	}
+
+	/* Drop characters after the cut by moving them into the gap. */
+	line_mv_gap(line, len);
+	line->len = len;
+
+	/* Shrink allocated capacity if most of it is useless now. */
+	if (line->cap > LINE_INLINE_CAP && len < line->cap / 2) {
+		if (len <= LINE_INLINE_CAP) {
+			/* Move characters inside the line. */
+			chars = line->raw.chars;
+			memcpy(line->raw.inl, chars, len);
+			free(chars);
+			line->cap = LINE_INLINE_CAP;
+		} else {
+			/* Keep the bigger buffer if it can not be shrunk. */
+			cap = len * 2;
+			chars = realloc(line->raw.chars, cap);
+			if (NULL == chars)
+				return;
+			line->raw.chars = chars;
+			line->cap = cap;
+		}
+	}
+}
+
+int
+line_del_char(struct line *const line, const size_t idx)
+{
+	int ret;
+
+	/* Validate index. */
+	if (idx >= line->len) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Make sure that line has own characters. */
+	ret = line_own(line);
+	if (-1 == ret)
+		return -1;
+
+	/* Remove character by joining it to the gap. */
+	line_mv_gap(line, idx);
+	line->len--;
+	line->gen++;
+	return 0;
+}
+
+void
+line_free(struct line *const line)
+{
+	/* Free allocated raw chars. */
+	if (line->cap > LINE_INLINE_CAP)
+		free(line->raw.chars);
+}
+
+static int
+line_grow_gap(struct line *const line, const size_t len)
+{
+	char *chars;
+	size_t cap;
+	const size_t after_len = line->len - line->gap_idx;
+
+	if (line->cap - line->len >= len)
+		return 0;
+
+	/* Double capacity to make insertions amortized constant. */
+	cap = MAX(line->cap * 2, line->len + len);
+
+	if (line->cap > LINE_INLINE_CAP) {
+		/* Reallocate characters and move ones after the gap to the end. */
+		chars = realloc(line->raw.chars, cap);
+		if (NULL == chars)
+			return -1;
+		memmove(&chars[cap - after_len], &chars[line->cap - after_len], after_len);
+	} else {
+		/* Move characters from the line to allocated buffer. */
+		chars = malloc(cap);
+		if (NULL == chars)
+			return -1;
+		memcpy(chars, line->raw.inl, line->gap_idx);
+		memcpy(&chars[cap - after_len], &line->raw.inl[line->cap - after_len],
+			after_len);
+	}
+
+	line->raw.chars = chars;
+	line->cap = cap;
+	return 0;
+}
+
+void
+line_init(struct line *const line, const size_t id)
+{
+	/* Whole inline buffer is the gap. */
+	line->len = 0;
+	line->cap = LINE_INLINE_CAP;
+	line->gap_idx = 0;
+	line->id = id;
+	line->gen = 0;
+}
+
+int
+line_ins(
+	struct line *const line,
+	const size_t idx,
+	const char *const chars,
+	const size_t len)
+{
+	int ret;
+
+	/* Validate index. */
+	if (idx > line->len) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Make sure that line has own characters. */
+	ret = line_own(line);
+	if (-1 == ret)
+		return -1;
+
+	/* Move the gap to the index and make sure it fits the characters. */
+	line_mv_gap(line, idx);
+	ret = line_grow_gap(line, len);
+	if (-1 == ret)
+		return -1;
+
+	/* Copy characters to the beginning of the gap. */
+	memcpy(&line_buf(line)[line->gap_idx], chars, len);
+	line->gap_idx += len;
+	line->len += len;
+	line->gen++;
+	return 0;
+}
+
+int
+line_ins_char(struct line *const line, const size_t idx, const char ch)
+{
+	return line_ins(line, idx, &ch, 1);
+}
+
+size_t
+line_len(const struct line *const line)
+{
+	return line->len;
+}
+
+void
+line_map(
+	struct line *const line,
+	const char *const chars,
+	const size_t len,
+	const size_t id)
+{
+	/* Point to the mapped content. */
+	line->len = len;
+	line->cap = 0;
+	line->gap_idx = 0;
+	line->raw.mapped = chars;
+	line->id = id;
+	line->gen = 0;
+}
+
+static void
+line_mv_gap(struct line *const line, const size_t idx)
+{
+	char *const buf = line_buf(line);
+	char *const gap = &buf[line->gap_idx];
+	const size_t gap_len = line->cap - line->len;
+
+	if (idx < line->gap_idx) {
+		/* Move characters before the gap to its end. */
+		memmove(&gap[gap_len - (line->gap_idx - idx)], &buf[idx],
+			line->gap_idx - idx);
+	} else if (idx > line->gap_idx) {
+		/* Move characters after the gap to its beginning. */
+		memmove(gap, &gap[gap_len], idx - line->gap_idx);
+	}
+	line->gap_idx = idx;
+}
+
+static int
+line_own(struct line *const line)
+{
+	char *chars;
+	size_t cap;
+	const char *mapped;
+
+	/* Characters are already copied. */
+	if (0 != line->cap)
+		return 0;
+	mapped = line->raw.mapped;
+
+	if (line->len <= LINE_INLINE_CAP) {
+		/* Copy mapped content inside the line. */
+		memcpy(line->raw.inl, mapped, line->len);
+		line->cap = LINE_INLINE_CAP;
+	} else {
+		/* Allocate characters buffer with the gap at the end. */
+		cap = line->len * 2;
+		chars = malloc(cap);
+		if (NULL == chars)
+			return -1;
+		memcpy(chars, mapped, line->len);
+		line->raw.chars = chars;
+		line->cap = cap;
+	}
+
+	/* The gap is at the end. */
+	line->gap_idx = line->len;
+	return 0;
+}
+
+const char*
+line_raw(
+	const struct line *const line,
+	size_t *const gap_idx,
+	size_t *const gap_len)
+{
+	/* Mapped content has no gap. */
+	if (0 == line->cap) {
+		*gap_idx = line->len;
+		*gap_len = 0;
+		return line->raw.mapped;
+	}
+
+	*gap_idx = line->gap_idx;
+	*gap_len = line->cap - line->len;
+	return line->cap > LINE_INLINE_CAP ? line->raw.chars : line->raw.inl;
+}
+
+void
+line_remap(
+	struct line *const line,
+	const char *const map,
+	const size_t len,
+	const char *const copy)
+{
+	/* Own content and content outside of the mapping are not moved. */
+	if (0 != line->cap || line->raw.mapped < map || line->raw.mapped > &map[len])
+		return;
+	line->raw.mapped = &copy[line->raw.mapped - map];
+}
+
+int
+line_search_bwd(
+	struct line *const line,
+	size_t *const idx,
+	const struct search *const search
+) {
+	const char *start;
+	const char *found;
+
+	/* Validate accepted index. */
+	if (*idx > line->len) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Search occurrence, which ends not after the index. */
+	start = line_chars(line);
+	found = search_bwd(search, start, *idx);
+	if (NULL == found)
+		return 0;
+
+	/* Set result. */
+	*idx = found - start;
+	return 1;
+}
+
+int
+line_search_fwd(
+	struct line *const line,
+	size_t *const idx,
+	const struct search *const search
+) {
+	const char *start;
+	const char *found;
+
+	/* Validate accepted index. */
+	if (*idx > line->len) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Search occurrence from the index. */
+	start = &line_chars(line)[*idx];
+	found = search_fwd(search, start, line->len - *idx);
+	if (NULL == found)
+		return 0;
+
+	/* Set result. */
+	*idx = found - start;
+	return 1;
+}
+
+size_t
+line_write(const struct line *const line, FILE *const f)
+{
+	int ret;
+	size_t written;
+	size_t gap_idx;
+	size_t gap_len;
+	const char *const chars = line_raw(line, &gap_idx, &gap_len);
+	const char *const after = &chars[gap_idx + gap_len];
+
+	/* Write characters around the gap to the file. */
+	written = fwrite(chars, sizeof(char), gap_idx, f);
+	written += fwrite(after, sizeof(char), line->len - gap_idx, f);
+
+	/* Check write error. */
+	if (written != line->len)
+		return 0;
+
+	/* Append newline to the end. */
+	ret = fputc('\n', f);
+	if (EOF == ret)
+		return 0;
+
+	/* Return written length. Do not forget about newline character. */
+	return written + 1;
+}
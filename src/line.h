@@ -0,0 +1,145 @@
+#ifndef _LINE_H
+#define _LINE_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "search.h"
+
+enum {
+	LINE_INLINE_CAP = 32, /* Capacity of own content stored in the line. */
+};
+
+/*
+ * Line of the opened file.
+ *
+ * Lines of the mapped file point to the mapping until the first edit. Then
+ * the content is copied to the own buffer. The own buffer has a gap, which
+ * follows edits, so inserting and deleting near the previous edit is cheap.
+ * Short own content is stored inside the line without allocation.
+ *
+ * Identity and edit generation of the line allow to cache data computed from
+ * its content, for example, the render.
+ */
+struct line {
+	size_t len; /* Length of raw content. */
+	size_t cap; /* Capacity of own content with the gap or 0 if it is mapped. */
+	size_t gap_idx; /* Index of the gap in own content. */
+	union {
+		const char *mapped; /* Mapped raw content. */
+		char *chars; /* Own content if capacity is bigger than inline one. */
+		char inl[LINE_INLINE_CAP]; /* Own content if capacity is inline. */
+	} raw; /* Raw content. Use functions to access it. */
+	size_t id; /* Identity of the line. Set by the line's owner. */
+	size_t gen; /* Edit generation. Incremented after every change. */
+};
+
+/*
+ * Appends passed chars to line.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int line_append(struct line *, const char *, size_t);
+
+/*
+ * Breaks the line at passed index. Writes broken right part to the passed
+ * line with passed identity.
+ *
+ * Returns 0 on success an -1 on error.
+ */
+int line_break(struct line *, size_t, struct line *, size_t);
+
+/*
+ * Gets contiguous raw characters of the line regardless of where they are
+ * stored. Moves the gap of own content to the end if needed.
+ */
+const char *line_chars(struct line *);
+
+/*
+ * Cuts a line and shrinks its capacity. The argument specifies how many first
+ * characters will remain. Never fails, the bigger buffer is kept if it can not
+ * be shrunk.
+ */
+void line_cut(struct line *, size_t);
+
+/*
+ * Deletes character from line at passed index.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int line_del_char(struct line *, size_t);
+
+/*
+ * Frees allocated line's buffer.
+ */
+void line_free(struct line *);
+
+/*
+ * Initializes empty line with passed identity. Do not forget to free it.
+ */
+void line_init(struct line *, size_t);
+
+/*
+ * Inserts passed chars to line at passed index.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int line_ins(struct line *, size_t, const char *, size_t);
+
+/*
+ * Inserts character to line at passed index.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int line_ins_char(struct line *, size_t, char);
+
+/*
+ * Gets length of raw characters of the line.
+ */
+size_t line_len(const struct line *);
+
+/*
+ * Initializes line with passed identity, which points to the mapped content.
+ * Do not forget to free it.
+ */
+void line_map(struct line *, const char *, size_t, size_t);
+
+/*
+ * Gets raw characters of the line without moving the gap. Writes index and
+ * length of the gap to passed pointers. Length is 0 if there is no gap.
+ */
+const char *line_raw(const struct line *, size_t *, size_t *);
+
+/*
+ * Moves the line, which points to the passed mapping of passed length, to the
+ * same place of passed copy of the mapping.
+ */
+void line_remap(struct line *, const char *, size_t, const char *);
+
+/*
+ * Searches query backward.
+ *
+ * Returns 1 if result found, 0 if no result and -1 if starting index is
+ * invalid.
+ *
+ * Sets `EINVAL` if index is invalid.
+ */
+int line_search_bwd(struct line *, size_t *, const struct search *);
+
+/*
+ * Searches query forward.
+ *
+ * Returns 1 if result found, 0 if no result and -1 if starting index is
+ * invalid.
+ *
+ * Sets `EINVAL` if index is invalid.
+ */
+int line_search_fwd(struct line *, size_t *, const struct search *);
+
+/*
+ * Writes a line to the file with `'\n'` at the end.
+ *
+ * Returns written bytes count on success and 0 on error.
+ */
+size_t line_write(const struct line *, FILE *);
+
+#endif /* _LINE_H */
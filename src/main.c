@@ -1,5 +1,5 @@
 /* TODO: v0.4: perror errors in goto-cleanups */
-/* TODO: v0.4: Create Cell struct to handle all symbols including UTF-8. Create structs Win->Renders->Render->Cells->Cell. Rerender lines on window side */
+/* TODO: v0.4: Create Cell struct to handle all symbols including UTF-8. Render cells in Win->Renders->Render. */
 /* TODO: v0.4: Use linked list for lines array and line's content parts. */
 /* TODO: v0.4: Remember last position per line. */
 /* TODO: v0.4: Open binary files and files with ^M at the end of line. */
@@ -7,33 +7,55 @@
 /* TODO: v0.5: Add key settings for escape sequences. For example, CFG_KEY_MV_UP_2 = "..." */
 /* TODO: v0.5: Add local clipboard. Use it in functions. */
 /* TODO: v0.5: Xclip patch to use with local clipboard. */
-/* TODO: v0.6: Support huge files: read chunks or try mmap */
 /* TODO: v0.6: Add tests. */
 /* TODO: v0.7: Make code patching easier. */
 /* TODO: v0.7: Add more error codes in docs. */
 /* TODO: v0.7: Save to spare dir on error. */
 
+#include <errno.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include "cfg.h"
 #include "ed.h"
 
-static const char *const usage = "Usage:\n\t$ se <filename>\n";
+static const char *const usage = "Usage:\n\t$ se [-t threads] <filename>\n";
 
 /*
- * Main loop of the program. Edits the file by passed filename.
+ * Main loop of the program. Edits the file by passed filename using passed
+ * count of threads for heavy operations.
  *
  * Returns `EXIT_SUCCESS` on success and `EXIT_FAILURE` on error.
  */
-static int edit(const char *);
+static int edit(const char *, size_t);
 
 /*
  * Editor signals handler.
  */
 static void handle_signal(int, siginfo_t *, void *);
 
+/*
+ * Checks that the frame must be drawn now. Frames are deferred while input is
+ * pending, so keys are processed without waiting the terminal. But the frame
+ * is drawn at least once per passed interval since the passed time of the
+ * previous frame, and always if there is no more input.
+ *
+ * Returns 1 if the frame must be drawn, 0 if not and -1 on error.
+ */
+static int need_to_draw(const struct timespec *, long);
+
+/*
+ * Parses positive count of threads, which is not greater than the max.
+ *
+ * Returns 0 on success and -1 on error.
+ *
+ * Sets `EINVAL` if string is not a positive number or the number is too big.
+ */
+static int parse_threads_cnt(const char *, size_t *);
+
 /*
  * Setups signal handler for the editor. Must be called after editor opening.
  *
@@ -45,13 +67,14 @@ static int setup_signal_handler(void);
 static struct ed *ed;
 
 static int
-edit(const char *const path)
+edit(const char *const path, const size_t threads_cnt)
 {
 	const char *err;
 	int ret;
+	struct timespec drawn = {0};
 
 	/* Opens file in the editor. */
-	ed = ed_open(path, STDIN_FILENO, STDOUT_FILENO);
+	ed = ed_open(path, STDIN_FILENO, STDOUT_FILENO, threads_cnt);
 	if (NULL == ed) {
 		perror("Failed to open the editor");
 		return EXIT_FAILURE;
@@ -66,12 +89,23 @@ edit(const char *const path)
 
 	/* Main event loop. */
 	while (!ed_need_to_quit(ed)) {
-		/* Draws editor's content on the screen. */
-		ret = ed_draw(ed);
+		/* Skip the frame if there are more keys to process. */
+		ret = need_to_draw(&drawn, CFG_FRAME_INTERVAL_MS);
 		if (-1 == ret) {
-			err = "Failed to draw";
+			err = "Failed to check that drawing is needed";
 			goto err_quit;
 		}
+
+		/* Draws editor's content on the screen. */
+		if (1 == ret) {
+			ret = ed_draw(ed);
+			if (-1 == ret) {
+				err = "Failed to draw";
+				goto err_quit;
+			}
+			clock_gettime(CLOCK_MONOTONIC, &drawn);
+		}
+
 		/* Wait and process key presses. */
 		ret = ed_wait_and_proc_key(ed);
 		if (-1 == ret) {
@@ -103,6 +137,51 @@ handle_signal(int signal, siginfo_t *info, void *ctx)
 	ed_reg_sig(ed, signal);
 }
 
+static int
+need_to_draw(const struct timespec *const drawn, const long interval_ms)
+{
+	int ret;
+	struct timespec now;
+	long elapsed_ms;
+
+	/* The final frame is drawn if there is no pending input. */
+	ret = ed_has_input(ed);
+	if (ret <= 0)
+		return -1 == ret ? -1 : 1;
+
+	/* Draw the frame anyway if the previous one is too old. */
+	ret = clock_gettime(CLOCK_MONOTONIC, &now);
+	if (-1 == ret)
+		return -1;
+	elapsed_ms = (now.tv_sec - drawn->tv_sec) * 1000
+		+ (now.tv_nsec - drawn->tv_nsec) / 1000000;
+	return elapsed_ms >= interval_ms;
+}
+
+static int
+parse_threads_cnt(const char *const str, size_t *const cnt)
+{
+	char *end;
+	unsigned long val;
+
+	/* Parse number and check that whole string is parsed. */
+	errno = 0;
+	val = strtoul(str, &end, 10);
+	if (0 != errno || end == str || '\0' != *end || 0 == val || '-' == *str) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Too many threads overflow sizes of chunks, which are handled at once. */
+	if (val > CFG_THREADS_MAX) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	*cnt = val;
+	return 0;
+}
+
 static int
 setup_signal_handler(void)
 {
@@ -125,17 +204,37 @@ setup_signal_handler(void)
 }
 
 int
-main(const int argc, const char *const *const argv)
+main(const int argc, char *const *const argv)
 {
 	int ret;
+	int opt;
+	size_t threads_cnt = CFG_THREADS_CNT;
+
+	/* Parse options. */
+	while (1) {
+		opt = getopt(argc, argv, "t:");
+		if (-1 == opt)
+			break;
+
+		switch (opt) {
+		case 't':
+			ret = parse_threads_cnt(optarg, &threads_cnt);
+			if (-1 == ret)
+				goto err_usage;
+			break;
+		default:
+			goto err_usage;
+		}
+	}
 
 	/* Check filename in arguments. */
-	if (argc != 2) {
-		fputs(usage, stderr);
-		return EXIT_FAILURE;
-	}
+	if (optind + 1 != argc)
+		goto err_usage;
 
 	/* Edit the file. */
-	ret = edit(argv[1]);
+	ret = edit(argv[optind], threads_cnt);
 	return ret;
+err_usage:
+	fputs(usage, stderr);
+	return EXIT_FAILURE;
 }
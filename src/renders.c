@@ -0,0 +1,561 @@
+#include <stdlib.h>
+#include <string.h>
+#include "cfg.h"
+#include "file.h"
+#include "math.h"
+#include "renders.h"
+#include "str.h"
+#include "tvec.h"
+
+/*
+ * Expanded tab of the line.
+ */
+struct tab {
+	size_t idx; /* Index of the tab in the line. */
+	size_t col; /* Column after the tab in the render. */
+};
+
+TVEC_DEF(tabs, struct tab)
+
+/*
+ * Rendered line. Tabs of the line are indexed, so columns of characters are
+ * found by binary search.
+ */
+struct render {
+	size_t id; /* Identity of rendered line. */
+	size_t gen; /* Edit generation of rendered line. */
+	size_t used; /* Tick of the last usage. */
+	char *chars; /* Rendered characters. */
+	size_t len; /* Length of rendered characters. */
+	size_t cap; /* Capacity of rendered characters. */
+	char is_raw; /* If set, then the line has no tabs and is its own render. */
+	struct tabs tabs; /* Tabs of the line in order of their indexes. */
+};
+
+/*
+ * Cache of renders.
+ */
+struct renders {
+	struct render *items; /* Renders. */
+	size_t len; /* Count of used renders. */
+	size_t cap; /* Max count of renders. */
+	size_t tick; /* Counter of renders usages. */
+};
+
+/*
+ * Gets actual render of passed line. Patches or renders the line in place of
+ * other render if the cache has no actual render of it.
+ *
+ * Returns pointer to render on success and `NULL` on error.
+ */
+static struct render *renders_find(struct renders *, const struct pub_line *);
+
+/*
+ * Finds render to replace with the render of passed line. Prefers outdated
+ * render of the same line, then not used render and then the least recently
+ * used one.
+ *
+ * Returns pointer to render.
+ */
+static struct render *renders_find_free(struct renders *, size_t);
+
+/*
+ * Indexes tabs of the line from passed index to the end. Accepts column of
+ * the index and writes column of the line's end by passed pointer.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+static int renders_index(
+	struct render *, const struct pub_line *, size_t, size_t *);
+
+/*
+ * Indexes tabs of passed part of the line. Accepts index and column of the
+ * part's beginning and writes ones of its end by passed pointers. Characters
+ * between tabs are skipped at once.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+static int renders_index_part(
+	struct tabs *, const char *, size_t, size_t *, size_t *);
+
+/*
+ * Patches render of the previous generation of the line using the edit, which
+ * made the current generation. Characters are rendered again only from the
+ * edit to the first tab after it because the tab realigns the rest of the
+ * line. The rest is shifted in place.
+ *
+ * Returns 1 if render is patched, 0 if it can not be patched and -1 on error.
+ */
+static int renders_patch(struct render *, const struct pub_line *);
+
+/*
+ * Renders passed line to passed render. Tabs are expanded with spaces. Line
+ * with contiguous characters and without tabs is not copied.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+static int renders_render(struct render *, const struct pub_line *);
+
+/*
+ * Renders part of characters to the end of existing render. Characters
+ * between tabs are copied at once.
+ */
+static void renders_render_part(struct render *, const char *, size_t);
+
+/*
+ * Renders characters of the line in passed range around the gap to the end of
+ * existing render.
+ */
+static void renders_render_range(
+	struct render *, const struct pub_line *, size_t, size_t);
+
+/*
+ * Gets count of indexed tabs before passed index of the line.
+ */
+static size_t renders_tabs_before(const struct render *, size_t);
+
+/*
+ * Gets column of passed index of the line using indexed tabs.
+ */
+static size_t renders_tabs_col(const struct render *, size_t);
+
+struct renders*
+renders_alloc(const size_t cap)
+{
+	struct renders *renders;
+
+	/* Allocate opaque struct. */
+	renders = malloc(sizeof(*renders));
+	if (NULL == renders)
+		return NULL;
+
+	/* Allocate renders. Their characters are allocated on demand. */
+	renders->cap = MAX(cap, 1);
+	renders->items = malloc(renders->cap * sizeof(*renders->items));
+	if (NULL == renders->items) {
+		free(renders);
+		return NULL;
+	}
+	renders->len = 0;
+	renders->tick = 0;
+	return renders;
+}
+
+int
+renders_col(
+	struct renders *const renders,
+	const struct pub_line *const line,
+	const size_t idx,
+	size_t *const col)
+{
+	const struct render *render;
+
+	/* Get render with indexed tabs. */
+	render = renders_find(renders, line);
+	if (NULL == render)
+		return -1;
+
+	*col = renders_tabs_col(render, MIN(idx, line->len));
+	return 0;
+}
+
+static struct render*
+renders_find(struct renders *const renders, const struct pub_line *const line)
+{
+	int ret;
+	size_t i;
+	struct render *render;
+
+	/* Find actual render of the line. */
+	for (i = 0; i < renders->len; i++) {
+		render = &renders->items[i];
+		if (render->id == line->id && render->gen == line->gen)
+			break;
+	}
+
+	/* Render the line in place of other render if it is not found. */
+	if (i == renders->len) {
+		render = renders_find_free(renders, line->id);
+		ret = renders_patch(render, line);
+		if (0 == ret)
+			ret = renders_render(render, line);
+		if (-1 == ret)
+			return NULL;
+	}
+
+	render->used = ++renders->tick;
+	return render;
+}
+
+static struct render*
+renders_find_free(struct renders *const renders, const size_t id)
+{
+	size_t i;
+	struct render *lru;
+
+	/* Outdated render of the same line is useless now. */
+	for (i = 0; i < renders->len; i++)
+		if (renders->items[i].id == id)
+			return &renders->items[i];
+
+	/* Use new render if the cache is not full. */
+	if (renders->len < renders->cap) {
+		lru = &renders->items[renders->len++];
+		lru->id = SIZE_MAX;
+		lru->chars = NULL;
+		lru->cap = 0;
+		tabs_init(&lru->tabs);
+		return lru;
+	}
+
+	/* Find the least recently used render. */
+	lru = &renders->items[0];
+	for (i = 1; i < renders->len; i++)
+		if (renders->items[i].used < lru->used)
+			lru = &renders->items[i];
+	return lru;
+}
+
+void
+renders_free(struct renders *const renders)
+{
+	size_t i;
+
+	for (i = 0; i < renders->len; i++) {
+		free(renders->items[i].chars);
+		tabs_free(&renders->items[i].tabs);
+	}
+	free(renders->items);
+	free(renders);
+}
+
+int
+renders_get(
+	struct renders *const renders,
+	const struct pub_line *const line,
+	const char **const chars,
+	size_t *const len)
+{
+	const struct render *render;
+
+	render = renders_find(renders, line);
+	if (NULL == render)
+		return -1;
+
+	*chars = render->is_raw ? line->chars : render->chars;
+	*len = render->len;
+	return 0;
+}
+
+int
+renders_idx(
+	struct renders *const renders,
+	const struct pub_line *const line,
+	const size_t col,
+	size_t *const idx)
+{
+	size_t lo = 0;
+	size_t hi;
+	size_t mid;
+	size_t i;
+	const struct tab *tab;
+	const struct render *render;
+
+	/* Get render with indexed tabs. */
+	render = renders_find(renders, line);
+	if (NULL == render)
+		return -1;
+
+	/* Binary search of tabs, which end not after the column. */
+	hi = render->tabs.len;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (tabs_at(&render->tabs, mid)->col <= col)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* Characters after the last of these tabs are not expanded. */
+	if (0 == lo) {
+		i = col;
+	} else {
+		tab = tabs_at(&render->tabs, lo - 1);
+		i = tab->idx + 1 + (col - tab->col);
+	}
+
+	/* The next tab covers the column if the column is inside it. */
+	if (lo < render->tabs.len) {
+		tab = tabs_at(&render->tabs, lo);
+		i = MIN(i, tab->idx + 1);
+	}
+
+	*idx = MIN(i, line->len);
+	return 0;
+}
+
+static int
+renders_index(
+	struct render *const render,
+	const struct pub_line *const line,
+	const size_t begin,
+	size_t *const col)
+{
+	int ret;
+	size_t idx = begin;
+	const char *const after = &line->chars[line->gap_len];
+
+	/* Index part before the gap and part after it. */
+	if (begin < line->gap_idx) {
+		ret = renders_index_part(&render->tabs, &line->chars[begin],
+			line->gap_idx - begin, &idx, col);
+		if (-1 == ret)
+			return -1;
+	}
+	if (line->len > idx) {
+		ret = renders_index_part(&render->tabs, &after[idx], line->len - idx,
+			&idx, col);
+		if (-1 == ret)
+			return -1;
+	}
+	return 0;
+}
+
+static int
+renders_index_part(
+	struct tabs *const tabs,
+	const char *chars,
+	const size_t len,
+	size_t *const idx,
+	size_t *const col)
+{
+	int ret;
+	const char *tab;
+	const char *const end = &chars[len];
+	struct tab item;
+
+	for (;;) {
+		/* Characters before the next tab are not expanded. */
+		tab = str_chr(chars, end - chars, '\t');
+		if (NULL == tab) {
+			*idx += end - chars;
+			*col += end - chars;
+			return 0;
+		}
+		*idx += tab - chars;
+		*col += tab - chars;
+
+		/* Expand and index the tab. */
+		*col += str_exp('\t', *col);
+		item.idx = (*idx)++;
+		item.col = *col;
+		ret = tabs_append(tabs, &item, 1);
+		if (-1 == ret)
+			return -1;
+		chars = tab + 1;
+	}
+}
+
+static int
+renders_patch(struct render *const render, const struct pub_line *const line)
+{
+	int ret;
+	size_t i;
+	size_t col;
+	size_t old_col;
+	size_t new_col;
+	size_t len;
+	size_t cap;
+	char *chars;
+	char ch;
+	const struct pub_edit *const edit = line->edit;
+	const size_t end = NULL == edit ? 0 : edit->idx + edit->ins_len;
+
+	/* Only own render of the previous generation can be patched. */
+	if (NULL == edit || render->id != line->id || render->gen + 1 != line->gen
+		|| render->is_raw)
+		return 0;
+
+	/* Removed characters are unknown, so they must be the end of the line. */
+	if (edit->del_len > 1 && end != line->len)
+		return 0;
+
+	/* Get column of the edit. It is the same in both renders. */
+	col = renders_tabs_col(render, edit->idx);
+	if (col > render->len)
+		return 0;
+
+	/* Get column after removed characters in the previous render. */
+	if (end == line->len)
+		old_col = render->len;
+	else if (1 == edit->del_len)
+		old_col = col + str_exp(edit->del_ch, col);
+	else
+		old_col = col;
+
+	/* Find where the rest of the line is aligned the same way as before. */
+	new_col = col;
+	for (i = edit->idx; i < line->len; i++) {
+		if (i >= end && new_col % CFG_TAB_SIZE == old_col % CFG_TAB_SIZE)
+			break;
+		ch = line->chars[i < line->gap_idx ? i : i + line->gap_len];
+		if (i >= end)
+			old_col += str_exp(ch, old_col);
+		new_col += str_exp(ch, new_col);
+	}
+
+	/* Previous render does not match the edit. */
+	if (old_col > render->len || (i == line->len && old_col != render->len))
+		return 0;
+
+	/* Grow render's capacity geometrically because the line is being typed. */
+	len = render->len - old_col + new_col;
+	if (len > render->cap) {
+		cap = MAX(len, render->cap + render->cap / 2);
+		chars = realloc(render->chars, cap);
+		if (NULL == chars)
+			return -1;
+		render->chars = chars;
+		render->cap = cap;
+	}
+
+	/* Shift the rest and render changed characters before it. */
+	memmove(&render->chars[new_col], &render->chars[old_col],
+		render->len - old_col);
+	render->len = col;
+	renders_render_range(render, line, edit->idx, i);
+	render->len = len;
+
+	/* Index tabs again from the edit. Tabs before it are not changed. */
+	render->tabs.len = renders_tabs_before(render, edit->idx);
+	ret = renders_index(render, line, edit->idx, &col);
+	if (-1 == ret) {
+		render->id = SIZE_MAX;
+		return -1;
+	}
+	render->gen = line->gen;
+	return 1;
+}
+
+static int
+renders_render(struct render *const render, const struct pub_line *const line)
+{
+	int ret;
+	size_t cap = 0;
+	char *chars;
+
+	/* Forget previous line until rendering is done. */
+	render->id = SIZE_MAX;
+	render->len = 0;
+	render->is_raw = 0;
+
+	/* Index tabs and calculate length of render. */
+	render->tabs.len = 0;
+	ret = renders_index(render, line, 0, &cap);
+	if (-1 == ret)
+		return -1;
+	tabs_shrink(&render->tabs);
+
+	/* Contiguous characters without tabs are the render. */
+	if (0 == render->tabs.len
+		&& (0 == line->gap_len || line->gap_idx == line->len)) {
+		render->len = line->len;
+		render->is_raw = 1;
+		render->id = line->id;
+		render->gen = line->gen;
+		return 0;
+	}
+
+	/* Grow render's capacity if needed. */
+	if (cap > render->cap) {
+		chars = realloc(render->chars, cap);
+		if (NULL == chars)
+			return -1;
+		render->chars = chars;
+		render->cap = cap;
+	}
+
+	/* Render characters around the gap. */
+	renders_render_range(render, line, 0, line->len);
+	render->id = line->id;
+	render->gen = line->gen;
+	return 0;
+}
+
+static void
+renders_render_part(
+	struct render *const render, const char *const chars, const size_t len)
+{
+	size_t run_len;
+	size_t exp;
+	const char *tab;
+	const char *start = chars;
+	const char *const end = &chars[len];
+
+	while (start < end) {
+		/* Copy characters before the next tab at once. */
+		tab = str_chr(start, end - start, '\t');
+		run_len = (NULL == tab ? end : tab) - start;
+		memcpy(&render->chars[render->len], start, run_len);
+		render->len += run_len;
+		if (NULL == tab)
+			return;
+
+		/* Expand tab with spaces. */
+		exp = str_exp('\t', render->len);
+		memset(&render->chars[render->len], ' ', exp);
+		render->len += exp;
+		start = tab + 1;
+	}
+}
+
+static void
+renders_render_range(
+	struct render *const render,
+	const struct pub_line *const line,
+	const size_t begin,
+	const size_t end)
+{
+	const char *const after = &line->chars[line->gap_len];
+
+	/* Render part before the gap and part after it. */
+	if (begin < line->gap_idx) {
+		renders_render_part(render, &line->chars[begin],
+			MIN(end, line->gap_idx) - begin);
+	}
+	if (end > line->gap_idx) {
+		renders_render_part(render, &after[MAX(begin, line->gap_idx)],
+			end - MAX(begin, line->gap_idx));
+	}
+}
+
+static size_t
+renders_tabs_before(const struct render *const render, const size_t idx)
+{
+	size_t lo = 0;
+	size_t hi = render->tabs.len;
+	size_t mid;
+
+	/* Binary search of the first tab at the index or after it. */
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (tabs_at(&render->tabs, mid)->idx < idx)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static size_t
+renders_tabs_col(const struct render *const render, const size_t idx)
+{
+	const struct tab *tab;
+	const size_t cnt = renders_tabs_before(render, idx);
+
+	/* Characters after the last tab before the index are not expanded. */
+	if (0 == cnt)
+		return idx;
+	tab = tabs_at(&render->tabs, cnt - 1);
+	return tab->col + (idx - tab->idx - 1);
+}
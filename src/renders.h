@@ -0,0 +1,56 @@
+#ifndef _RENDERS_H
+#define _RENDERS_H
+
+#include <stddef.h>
+#include "file.h"
+
+/*
+ * Opaque cache of lines rendered how they look in the window. Render is found
+ * by line's identity and edit generation, so the changed line is rendered
+ * again. The least recently used render is replaced if the cache is full.
+ * Tabs of rendered lines are indexed to map indexes to columns and back.
+ */
+struct renders;
+
+/*
+ * Allocates empty cache for passed count of renders. Cache keeps at least one
+ * render. Do not forget to free it.
+ *
+ * Returns pointer to opaque cache on success and `NULL` on error.
+ */
+struct renders *renders_alloc(size_t);
+
+/*
+ * Gets column of passed index of the line in its render. Index after the end
+ * of the line is the end. Renders the line if the cache has no actual render
+ * of it.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int renders_col(struct renders *, const struct pub_line *, size_t, size_t *);
+
+/*
+ * Frees allocated cache with its renders.
+ */
+void renders_free(struct renders *);
+
+/*
+ * Gets render of passed line. Renders the line if the cache has no actual
+ * render of it. Writes pointer to render and its length to passed pointers.
+ * Render is valid until the next call with other line and until the line is
+ * changed.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int renders_get(struct renders *, const struct pub_line *, const char **, size_t *);
+
+/*
+ * Gets the first index of the line, which is not before passed column in its
+ * render. Gets length of the line if the column is after the end. Renders the
+ * line if the cache has no actual render of it.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int renders_idx(struct renders *, const struct pub_line *, size_t, size_t *);
+
+#endif /* _RENDERS_H */
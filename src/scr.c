@@ -0,0 +1,334 @@
+#include <stdlib.h>
+#include <string.h>
+#include "buf.h"
+#include "esc.h"
+#include "math.h"
+#include "scr.h"
+
+/*
+ * Shadow screen.
+ */
+struct scr {
+	struct scr_row *prev; /* Rows of the previous frame. */
+	struct scr_row *next; /* Rows of the next frame. */
+	unsigned short rows; /* Count of rows. */
+	unsigned short cols; /* Count of columns. */
+	char is_cleared; /* If set, then the next frame is drawn from scratch. */
+	unsigned short scroll_top; /* The first scrolled row. */
+	unsigned short scroll_end; /* Row after the last scrolled row. */
+	int scroll_shift; /* Rows to scroll up if positive and down if negative. */
+};
+
+/*
+ * Scrolls rows of the previous frame on the screen using scroll region, so
+ * rows, which are still visible, are not drawn again.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+static int scr_flush_scroll(struct scr *, struct buf *);
+
+/*
+ * Appends update of passed row from the previous frame to the next one. Only
+ * the span from the first changed column to the last one is drawn and the
+ * rest of the previous row is cleared if the next row is shorter. Row's
+ * attributes are set only if they differ from passed terminal's ones.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+static int scr_flush_row(struct scr *, struct buf *, struct buf_refs *,
+	struct esc_sgr *, unsigned short);
+
+/*
+ * Frees passed count of rows and the array of rows.
+ */
+static void scr_free_rows(struct scr_row *, unsigned short);
+
+/*
+ * Reverses order of passed count of rows.
+ */
+static void scr_reverse_rows(struct scr_row *, unsigned short);
+
+struct scr*
+scr_alloc(void)
+{
+	struct scr *scr;
+
+	/* Allocate opaque struct. Rows are allocated on resize. */
+	scr = malloc(sizeof(*scr));
+	if (NULL == scr)
+		return NULL;
+	scr->prev = NULL;
+	scr->next = NULL;
+	scr->rows = 0;
+	scr->cols = 0;
+	scr->is_cleared = 1;
+	scr->scroll_shift = 0;
+	return scr;
+}
+
+int
+scr_flush(
+	struct scr *const scr, struct buf *const buf, struct buf_refs *const refs)
+{
+	int ret;
+	unsigned short row;
+	struct esc_sgr sgr = {0};
+	struct scr_row *const prev = scr->prev;
+
+	/* Clear the screen if previous frame is unknown. */
+	if (scr->is_cleared) {
+		ret = esc_go_home(buf);
+		if (-1 == ret)
+			return -1;
+		ret = esc_clr_win(buf);
+		if (-1 == ret)
+			return -1;
+	}
+
+	/* Scroll rows, which are still visible, and update changed rows. */
+	ret = scr_flush_scroll(scr, buf);
+	if (-1 == ret)
+		return -1;
+	for (row = 0; row < scr->rows; row++) {
+		ret = scr_flush_row(scr, buf, refs, &sgr, row);
+		if (-1 == ret)
+			return -1;
+	}
+
+	/* Do not leave attributes to other output. */
+	ret = esc_sgr_reset(buf, &sgr);
+	if (-1 == ret)
+		return -1;
+
+	/* The next frame is on the screen now. */
+	scr->prev = scr->next;
+	scr->next = prev;
+	scr->is_cleared = 0;
+	return 0;
+}
+
+static int
+scr_flush_scroll(struct scr *const scr, struct buf *const buf)
+{
+	int ret;
+	unsigned short row;
+	unsigned short cnt;
+	unsigned short len;
+	struct scr_row *rows;
+	const int shift = scr->scroll_shift;
+	const unsigned short top = scr->scroll_top;
+	const unsigned short end = scr->scroll_end;
+
+	/* Nothing to scroll if all rows are drawn again anyway. */
+	scr->scroll_shift = 0;
+	if (scr->is_cleared || 0 == shift || top >= end || shift >= end - top
+		|| -shift >= end - top)
+		return 0;
+	cnt = shift < 0 ? -shift : shift;
+
+	/* Scroll rows on the terminal inside the region. */
+	ret = esc_scroll_region(buf, top, end - 1);
+	if (-1 == ret)
+		return -1;
+	ret = shift > 0 ? esc_scroll_up(buf, cnt) : esc_scroll_down(buf, cnt);
+	if (-1 == ret)
+		return -1;
+	ret = esc_scroll_region_reset(buf);
+	if (-1 == ret)
+		return -1;
+
+	/* Rotate rows of the previous frame the same way. */
+	len = end - top;
+	rows = &scr->prev[top];
+	scr_reverse_rows(rows, len);
+	if (shift > 0) {
+		scr_reverse_rows(rows, len - cnt);
+		scr_reverse_rows(&rows[len - cnt], cnt);
+	} else {
+		scr_reverse_rows(rows, cnt);
+		scr_reverse_rows(&rows[cnt], len - cnt);
+	}
+
+	/* Appeared rows are empty on the screen. */
+	for (row = shift > 0 ? len - cnt : 0; cnt-- > 0; row++) {
+		rows[row].attrs.len = 0;
+		rows[row].chars.len = 0;
+	}
+	return 0;
+}
+
+static int
+scr_flush_row(
+	struct scr *const scr,
+	struct buf *const buf,
+	struct buf_refs *const refs,
+	struct esc_sgr *const sgr,
+	const unsigned short row)
+{
+	int ret;
+	size_t begin = 0;
+	size_t end;
+	struct buf tmp;
+	const char *chars;
+	struct scr_row *const prev = &scr->prev[row];
+	struct scr_row *const next = &scr->next[row];
+	const size_t prev_len =
+		scr->is_cleared ? 0 : MIN(prev->chars.len, scr->cols);
+	size_t next_len;
+
+	/* Referenced characters are compared as is if nothing is copied. */
+	if (next->ref_len > 0 && next->chars.len > 0) {
+		ret = buf_append(&next->chars, next->ref, next->ref_len);
+		if (-1 == ret)
+			return -1;
+		next->ref_len = 0;
+	}
+	chars = next->ref_len > 0 ? next->ref : next->chars.items;
+	next_len = MIN(next->ref_len > 0 ? next->ref_len : next->chars.len,
+		scr->cols);
+
+	/* Draw the whole row if the screen is cleared or attributes are changed. */
+	end = next_len;
+	if (!scr->is_cleared && prev->attrs.len == next->attrs.len
+		&& 0 == memcmp(prev->attrs.items, next->attrs.items, next->attrs.len)) {
+		/* Skip columns, which are not changed, at the beginning. */
+		while (begin < MIN(prev_len, next_len)
+			&& prev->chars.items[begin] == chars[begin])
+			begin++;
+
+		/* Skip columns, which are not changed, at the end of same length. */
+		if (prev_len == next_len) {
+			while (end > begin && prev->chars.items[end - 1] == chars[end - 1])
+				end--;
+		}
+
+		/* Nothing to update. Rows are the same, so just take the previous one. */
+		if (begin == end && prev_len <= next_len) {
+			if (next->ref_len > 0) {
+				tmp = next->chars;
+				next->chars = prev->chars;
+				prev->chars = tmp;
+			}
+			return 0;
+		}
+	}
+
+	/* Copy changed referenced characters to keep them for the next frame. */
+	if (next->ref_len > 0) {
+		ret = buf_append(&next->chars, next->ref, next_len);
+		if (-1 == ret)
+			return -1;
+		chars = next->chars.items;
+	}
+
+	/* Draw changed span with row's attributes. */
+	ret = esc_cur_set(buf, row, begin);
+	if (-1 == ret)
+		return -1;
+	ret = esc_sgr_set(buf, sgr, next->attrs.items, next->attrs.len);
+	if (-1 == ret)
+		return -1;
+	ret = buf_append_ref(buf, refs, &chars[begin], end - begin);
+	if (-1 == ret)
+		return -1;
+
+	/* Clear the rest of the previous row. */
+	if (prev_len > next_len) {
+		ret = esc_clr_row_end(buf);
+		if (-1 == ret)
+			return -1;
+	}
+	return 0;
+}
+
+void
+scr_free(struct scr *const scr)
+{
+	scr_free_rows(scr->prev, scr->rows);
+	scr_free_rows(scr->next, scr->rows);
+	free(scr);
+}
+
+static void
+scr_free_rows(struct scr_row *const rows, const unsigned short cnt)
+{
+	unsigned short row;
+
+	if (NULL == rows)
+		return;
+	for (row = 0; row < cnt; row++) {
+		buf_free(&rows[row].attrs);
+		buf_free(&rows[row].chars);
+	}
+	free(rows);
+}
+
+int
+scr_resize(
+	struct scr *const scr, const unsigned short rows, const unsigned short cols)
+{
+	struct scr_row *prev;
+	struct scr_row *next;
+
+	/* Nothing to do if the size is the same. */
+	if (rows == scr->rows && cols == scr->cols)
+		return 0;
+
+	/* Allocate empty rows. Zeroed typed vectors are empty. */
+	prev = calloc(MAX(rows, 1), sizeof(*prev));
+	if (NULL == prev)
+		return -1;
+	next = calloc(MAX(rows, 1), sizeof(*next));
+	if (NULL == next) {
+		free(prev);
+		return -1;
+	}
+
+	/* Replace rows of the old size and clear the screen in the next frame. */
+	scr_free_rows(scr->prev, scr->rows);
+	scr_free_rows(scr->next, scr->rows);
+	scr->prev = prev;
+	scr->next = next;
+	scr->rows = rows;
+	scr->cols = cols;
+	scr->is_cleared = 1;
+	return 0;
+}
+
+static void
+scr_reverse_rows(struct scr_row *const rows, const unsigned short cnt)
+{
+	unsigned short i;
+	struct scr_row tmp;
+
+	for (i = 0; i < cnt / 2; i++) {
+		tmp = rows[i];
+		rows[i] = rows[cnt - 1 - i];
+		rows[cnt - 1 - i] = tmp;
+	}
+}
+
+struct scr_row*
+scr_row(struct scr *const scr, const unsigned short row)
+{
+	struct scr_row *const next = &scr->next[row];
+
+	/* Row of the next frame is drawn from scratch. */
+	next->attrs.len = 0;
+	next->chars.len = 0;
+	next->ref = NULL;
+	next->ref_len = 0;
+	return next;
+}
+
+void
+scr_scroll(
+	struct scr *const scr,
+	const unsigned short top,
+	const unsigned short end,
+	const int shift)
+{
+	scr->scroll_top = top;
+	scr->scroll_end = end;
+	scr->scroll_shift = shift;
+}
@@ -0,0 +1,71 @@
+#ifndef _SCR_H
+#define _SCR_H
+
+#include "buf.h"
+
+/*
+ * Opaque shadow screen. Keeps rows of the previous frame, so the next frame
+ * is drawn by updating only changed parts of rows.
+ */
+struct scr;
+
+/*
+ * Row of the frame. Attributes are escape sequences, which begin colored
+ * output of the row, and characters are drawn after them. Long characters,
+ * for example, part of the line's render, are referenced instead of copying.
+ * They are copied only if the row is changed.
+ */
+struct scr_row {
+	struct buf attrs; /* Escape sequences of the row's attributes. */
+	struct buf chars; /* Characters of the row. One character is one column. */
+	const char *ref; /* Characters after copied ones. Valid until flushing. */
+	size_t ref_len; /* Length of referenced characters. */
+};
+
+/*
+ * Allocates empty screen. Resize it before the first frame. Do not forget to
+ * free it.
+ *
+ * Returns pointer to opaque screen on success and `NULL` on error.
+ */
+struct scr *scr_alloc(void);
+
+/*
+ * Appends updates of the screen from the previous frame to the next one to
+ * passed buffer. Changed characters are appended by references to the rows,
+ * which are valid until the next frame is drawn. Every row of the next frame
+ * must be drawn before. The next frame becomes the previous one.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int scr_flush(struct scr *, struct buf *, struct buf_refs *);
+
+/*
+ * Frees allocated screen with its rows.
+ */
+void scr_free(struct scr *);
+
+/*
+ * Resizes the screen to passed count of rows and columns. The next frame is
+ * drawn on cleared screen if the size is changed.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int scr_resize(struct scr *, unsigned short, unsigned short);
+
+/*
+ * Gets cleared row of the next frame by its index, which must be less than
+ * count of rows.
+ */
+struct scr_row *scr_row(struct scr *, unsigned short);
+
+/*
+ * Scrolls rows of the previous frame from the first passed row to the second
+ * one exclusive. Rows are scrolled up by passed count if it is positive and
+ * down if it is negative. The screen scrolls them itself while flushing, so
+ * rows, which are still visible, are not drawn again. Only the last scroll
+ * before flushing is used.
+ */
+void scr_scroll(struct scr *, unsigned short, unsigned short, int);
+
+#endif /* _SCR_H */
@@ -0,0 +1,194 @@
+#include <errno.h>
+#include <string.h>
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define SEARCH_SSE2
+#endif
+#include "search.h"
+#include "str.h"
+
+enum {
+	SEARCH_SKIP_MIN_LEN = 16, /* Minimal query length to search with skips. */
+};
+
+/*
+ * Searches the last occurrence using the Horspool algorithm.
+ */
+static const char *search_skip_bwd(const struct search *, const char *, size_t);
+
+/*
+ * Searches the first occurrence using the Horspool algorithm.
+ */
+static const char *search_skip_fwd(const struct search *, const char *, size_t);
+
+const char*
+search_bwd(const struct search *const search, const char *const str, size_t len)
+{
+#ifdef SEARCH_SSE2
+	int i;
+	int mask;
+	__m128i first;
+	__m128i last;
+	__m128i begins;
+	__m128i ends;
+	const char *const query = search->query;
+	const size_t query_len = search->len;
+#endif
+
+	/* Empty query is never found. */
+	if (0 == search->len || len < search->len)
+		return NULL;
+#ifdef SEARCH_SSE2
+	if (query_len < SEARCH_SKIP_MIN_LEN) {
+		first = _mm_set1_epi8(query[0]);
+		last = _mm_set1_epi8(query[query_len - 1]);
+
+		/*
+		 * Compare the first and the last characters of 16 occurrences at
+		 * once. Check matched ones from the end of the block.
+		 */
+		for (; len - query_len + 1 >= sizeof(first); len -= sizeof(first)) {
+			begins = _mm_loadu_si128(
+				(const __m128i *)&str[len - query_len + 1 - sizeof(first)]);
+			ends = _mm_loadu_si128((const __m128i *)&str[len - sizeof(first)]);
+			mask = _mm_movemask_epi8(_mm_and_si128(
+				_mm_cmpeq_epi8(begins, first), _mm_cmpeq_epi8(ends, last)));
+			while (0 != mask) {
+				i = 31 - __builtin_clz(mask);
+				if (0 == memcmp(
+					&str[len - query_len + 1 - sizeof(first) + i],
+					query,
+					query_len
+				))
+					return &str[len - query_len + 1 - sizeof(first) + i];
+				mask &= ~(1 << i);
+			}
+		}
+	}
+#endif
+	/* Search the rest with skips. */
+	return search_skip_bwd(search, str, len);
+}
+
+const char*
+search_fwd(const struct search *const search, const char *str, size_t len)
+{
+#ifdef SEARCH_SSE2
+	int mask;
+	__m128i first;
+	__m128i last;
+	__m128i begins;
+	__m128i ends;
+	const char *const query = search->query;
+	const size_t query_len = search->len;
+#endif
+
+	/* Empty query is never found. */
+	if (0 == search->len || len < search->len)
+		return NULL;
+	if (1 == search->len)
+		return str_chr(str, len, search->query[0]);
+#ifdef SEARCH_SSE2
+	if (query_len < SEARCH_SKIP_MIN_LEN) {
+		first = _mm_set1_epi8(query[0]);
+		last = _mm_set1_epi8(query[query_len - 1]);
+
+		/*
+		 * Compare the first and the last characters of 16 occurrences at
+		 * once. Check matched ones from the beginning of the block.
+		 */
+		for (; len - query_len + 1 >= sizeof(first); str += sizeof(first)) {
+			begins = _mm_loadu_si128((const __m128i *)str);
+			ends = _mm_loadu_si128((const __m128i *)&str[query_len - 1]);
+			mask = _mm_movemask_epi8(_mm_and_si128(
+				_mm_cmpeq_epi8(begins, first), _mm_cmpeq_epi8(ends, last)));
+			while (0 != mask) {
+				if (0 == memcmp(&str[__builtin_ctz(mask)], query, query_len))
+					return &str[__builtin_ctz(mask)];
+				mask &= mask - 1;
+			}
+			len -= sizeof(first);
+		}
+	}
+#endif
+	/* Search the rest with skips. */
+	return search_skip_fwd(search, str, len);
+}
+
+void
+search_init(struct search *const search)
+{
+	search->len = 0;
+}
+
+int
+search_set(struct search *const search, const char *const query, const size_t len)
+{
+	size_t i;
+
+	/* Validate query length. */
+	if (len > sizeof(search->query)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Keep skips of the same query. */
+	if (len == search->len && 0 == memcmp(search->query, query, len))
+		return 0;
+	memcpy(search->query, query, len);
+	search->len = len;
+
+	/* Skip the whole query if the character is not in it. */
+	memset(search->fwd_skips, len, sizeof(search->fwd_skips));
+	memset(search->bwd_skips, len, sizeof(search->bwd_skips));
+
+	/* Otherwise align the window to the nearest occurrence of character. */
+	for (i = 0; i + 1 < len; i++)
+		search->fwd_skips[(unsigned char)query[i]] = len - 1 - i;
+	for (i = len; i-- > 1;)
+		search->bwd_skips[(unsigned char)query[i]] = i;
+	return 0;
+}
+
+static const char*
+search_skip_bwd(
+	const struct search *const search,
+	const char *const str,
+	const size_t len
+) {
+	size_t i;
+	const char *const query = search->query;
+	const size_t query_len = search->len;
+
+	if (len < query_len)
+		return NULL;
+
+	/* Shift the window by its first character. */
+	for (i = len - query_len;; i -= search->bwd_skips[(unsigned char)str[i]]) {
+		if (query[0] == str[i] && 0 == memcmp(&str[i], query, query_len))
+			return &str[i];
+		if (i < search->bwd_skips[(unsigned char)str[i]])
+			return NULL;
+	}
+}
+
+static const char*
+search_skip_fwd(
+	const struct search *const search,
+	const char *const str,
+	const size_t len
+) {
+	size_t i;
+	const char *const query = search->query;
+	const size_t query_len = search->len;
+	const char last = query[query_len - 1];
+
+	/* Shift the window by its last character. */
+	for (i = 0; i + query_len <= len;
+		i += search->fwd_skips[(unsigned char)str[i + query_len - 1]]) {
+		if (last == str[i + query_len - 1]
+			&& 0 == memcmp(&str[i], query, query_len))
+			return &str[i];
+	}
+	return NULL;
+}
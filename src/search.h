@@ -0,0 +1,53 @@
+#ifndef _SEARCH_H
+#define _SEARCH_H
+
+#include <limits.h>
+#include <stddef.h>
+
+enum {
+	SEARCH_QUERY_MAX_LEN = UCHAR_MAX, /* Shifts of longer query do not fit. */
+};
+
+/*
+ * Prepared search of the query. Keep it while the query is the same, so its
+ * skip tables are not built again on every search.
+ *
+ * Short query is found by its first and last characters, which are compared
+ * at many positions at once, and long one using the Horspool algorithm.
+ */
+struct search {
+	char query[SEARCH_QUERY_MAX_LEN]; /* Searched characters. */
+	size_t len; /* Length of the query. */
+	unsigned char fwd_skips[UCHAR_MAX + 1]; /* Shifts by the window's last. */
+	unsigned char bwd_skips[UCHAR_MAX + 1]; /* Shifts by the window's first. */
+};
+
+/*
+ * Searches the last occurrence of the query in passed characters.
+ *
+ * Returns pointer to the beginning of found occurrence or `NULL` if not found.
+ */
+const char *search_bwd(const struct search *, const char *, size_t);
+
+/*
+ * Searches the first occurrence of the query in passed characters.
+ *
+ * Returns pointer to the beginning of found occurrence or `NULL` if not found.
+ */
+const char *search_fwd(const struct search *, const char *, size_t);
+
+/*
+ * Initializes search of empty query, which is never found.
+ */
+void search_init(struct search *);
+
+/*
+ * Prepares search of passed query. Does nothing if the query is not changed.
+ *
+ * Returns 0 on success and -1 on error.
+ *
+ * Sets `EINVAL` if the query is too long.
+ */
+int search_set(struct search *, const char *, size_t);
+
+#endif /* _SEARCH_H */
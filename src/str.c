@@ -1,8 +1,52 @@
 #include <string.h>
 #include <stdlib.h>
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define STR_SSE2
+#endif
 #include "cfg.h"
 #include "str.h"
 
+const char*
+str_chr(const char *const str, const size_t len, const char ch)
+{
+	size_t i = 0;
+#ifdef STR_SSE2
+	int mask;
+	const __m128i needle = _mm_set1_epi8(ch);
+	__m128i block;
+
+	/* Compare 16 bytes at once and get the first match from the mask. */
+	for (; i + sizeof(block) <= len; i += sizeof(block)) {
+		block = _mm_loadu_si128((const __m128i *)&str[i]);
+		mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+		if (0 != mask)
+			return &str[i + __builtin_ctz(mask)];
+	}
+#else
+	unsigned long word;
+	const unsigned long ones = (unsigned long)-1 / 0xff;
+	const unsigned long highs = ones << 7;
+	const unsigned long pattern = ones * (unsigned char)ch;
+
+	/*
+	 * Compare a word at once. Matched bytes become zero after xor, so stop
+	 * if the word has a zero byte. The match is found byte by byte below.
+	 */
+	for (; i + sizeof(word) <= len; i += sizeof(word)) {
+		memcpy(&word, &str[i], sizeof(word));
+		word ^= pattern;
+		if (0 != ((word - ones) & ~word & highs))
+			break;
+	}
+#endif
+	/* Compare the rest byte by byte. */
+	for (; i < len; i++)
+		if (ch == str[i])
+			return &str[i];
+	return NULL;
+}
+
 char*
 str_copy(const char *const str, const size_t len)
 {
@@ -3,6 +3,14 @@
 
 #include <stddef.h>
 
+/*
+ * Like `memchr`, but scans several bytes at once. Uses SSE2 if available and
+ * compares machine words otherwise.
+ *
+ * Returns pointer to the first found character or `NULL` if not found.
+ */
+const char *str_chr(const char *, size_t, char);
+
 /*
  * Returns allocated copy of passed string on success and `NULL` on error. Do
  * not forget to free it.
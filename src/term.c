@@ -1,6 +1,10 @@
 #include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <sys/uio.h>
 #include <termios.h>
 #include <unistd.h>
+#include "math.h"
 #include "term.h"
 
 /*
@@ -78,29 +82,65 @@ term_set_raw_mode_params(struct termios *const params)
 	params->c_cc[VMIN] = 1;
 }
 
-size_t
-term_wait_key(char *const seq, const size_t len)
+ssize_t
+term_read(char *const buf, const size_t len)
 {
 	ssize_t readed;
 
-	/* Read input up to specified length. */
-	readed = read(term.ifd, seq, len);
+	/* Read available input up to specified length. */
+	readed = read(term.ifd, buf, len);
 	/*
 	 * We ignore the system call interruption that can occur when the window size
 	 * is changed, for example, in xterm.
 	 */
-	if (-1 == readed && errno != EINTR)
+	if (-1 == readed && EINTR == errno)
 		return 0;
-	/* It's ok to return signed because of error check before. */
+	/* End of input means that the terminal is lost. */
+	if (0 == readed) {
+		errno = EIO;
+		return -1;
+	}
 	return readed;
 }
 
-ssize_t
-term_write(const char *const buf, const size_t len)
+int
+term_wait_input(const int timeout)
+{
+	int ret;
+	struct pollfd fd;
+
+	/* Wait input on the input descriptor. */
+	fd.fd = term.ifd;
+	fd.events = POLLIN;
+	ret = poll(&fd, 1, timeout);
+	/* Interruption is not an error. Signals are processed before drawing. */
+	if (-1 == ret && EINTR == errno)
+		return 0;
+	return ret;
+}
+
+int
+term_writev(struct iovec *parts, size_t cnt)
 {
 	ssize_t written;
 
-	/* Write buffer with accepted length. */
-	written = write(term.ofd, buf, len);
-	return written;
+	while (cnt > 0) {
+		/* The kernel may write only a part of big frame, so write the rest. */
+		written = writev(term.ofd, parts, MIN(cnt, IOV_MAX));
+		if (-1 == written) {
+			/* Interruption is not an error. Signals are processed later. */
+			if (EINTR == errno)
+				continue;
+			return -1;
+		}
+
+		/* Skip written parts and move the beginning of partly written one. */
+		for (; cnt > 0 && (size_t)written >= parts->iov_len; parts++, cnt--)
+			written -= parts->iov_len;
+		if (cnt > 0) {
+			parts->iov_base = (char *)parts->iov_base + written;
+			parts->iov_len -= written;
+		}
+	}
+	return 0;
 }
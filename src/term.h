@@ -3,6 +3,7 @@
 
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 
 /*
  * Deinitializes initialized terminal.
@@ -27,20 +28,28 @@ int term_get_win_size(struct winsize *);
 int term_init(int, int);
 
 /*
- * Waits for a key press.
+ * Reads available input up to passed length. Waits for input if there is no
+ * available input.
  *
- * Key press sometimes consists of several characters. Therefore, the pressed
- * key's characters is written to the passed buffer up to the passed length.
+ * Returns count of read characters on success, 0 on interruption and -1 on
+ * error or end of input.
+ */
+ssize_t term_read(char *, size_t);
+
+/*
+ * Waits for input up to passed count of milliseconds.
  *
- * Returns readed characters count on success and 0 on error.
+ * Returns 1 if there is input, 0 on timeout or interruption and -1 on error.
  */
-size_t term_wait_key(char *, size_t);
+int term_wait_input(int);
 
 /*
- * Writes passed data to the terminal in one system call.
+ * Writes all data of passed count of parts to the terminal at once. Short and
+ * interrupted writes are continued, so the frame is never cut. Parts are
+ * changed during writing.
  *
  * Returns 0 on success and -1 on error.
  */
-ssize_t term_write(const char *, size_t);
+int term_writev(struct iovec *, size_t);
 
 #endif /* _TERM_H */
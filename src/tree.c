@@ -0,0 +1,503 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tree.h"
+
+enum {
+	TREE_NODE_CAP = 32, /* Max count of node's children. */
+	TREE_NODE_MIN = 8, /* Node is merged with neighbour if it has less. */
+};
+
+/*
+ * Node of the tree. Children of the leaf are items. One more child is allowed
+ * during insertion before splitting.
+ */
+struct node {
+	size_t cnt; /* Count of children. */
+	char is_leaf; /* If set, then children are items. */
+	size_t lens[TREE_NODE_CAP + 1]; /* Counts of items in children. */
+	size_t weights[TREE_NODE_CAP + 1]; /* Total weights of children. */
+	void *children[TREE_NODE_CAP + 1]; /* Child nodes or items. */
+};
+
+/*
+ * Counted B+ tree.
+ */
+struct tree {
+	struct node *root; /* Root node. There is always a root. */
+	size_t len; /* Count of items. */
+	size_t weight; /* Total weight of items. */
+};
+
+/*
+ * Allocates empty node. Do not forget to free it.
+ *
+ * Returns pointer to node on success and `NULL` on error.
+ */
+static struct node *node_alloc(char);
+
+/*
+ * Frees node and its child nodes. Items are not freed.
+ */
+static void node_free(struct node *);
+
+/*
+ * Inserts item with weight by index to the subtree. Writes new node to the
+ * passed pointer if the node is split or `NULL` otherwise.
+ *
+ * Returns 0 on success and -1 on error. The subtree is not changed on error.
+ */
+static int node_ins(struct node *, size_t, void *, size_t, struct node **);
+
+/*
+ * Merges node's child with its neighbour if they are small enough.
+ */
+static void node_merge(struct node *, size_t);
+
+/*
+ * Removes item by index from the subtree.
+ *
+ * Returns weight of removed item.
+ */
+static size_t node_rm(struct node *, size_t);
+
+/*
+ * Removes child of the node by index and shifts next children left.
+ */
+static void node_rm_child(struct node *, size_t);
+
+/*
+ * Sets weight of item by index in the subtree.
+ *
+ * Returns previous weight of the item.
+ */
+static size_t node_set_weight(struct node *, size_t, size_t);
+
+/*
+ * Shifts children of the node right to make space for new child by index.
+ */
+static void node_shift_children(struct node *, size_t);
+
+/*
+ * Moves the second half of node's children to passed empty node.
+ */
+static void node_split(struct node *, struct node *);
+
+/*
+ * Calculates count of items and total weight of node's children.
+ */
+static void node_sum(const struct node *, size_t *, size_t *);
+
+static struct node*
+node_alloc(const char is_leaf)
+{
+	struct node *node;
+
+	node = malloc(sizeof(*node));
+	if (NULL == node)
+		return NULL;
+	node->cnt = 0;
+	node->is_leaf = is_leaf;
+	return node;
+}
+
+static void
+node_free(struct node *const node)
+{
+	size_t i;
+
+	/* Free child nodes. */
+	if (!node->is_leaf)
+		for (i = 0; i < node->cnt; i++)
+			node_free(node->children[i]);
+	free(node);
+}
+
+static int
+node_ins(
+	struct node *const node,
+	size_t idx,
+	void *const item,
+	const size_t weight,
+	struct node **const split)
+{
+	int ret;
+	size_t i;
+	struct node *child;
+	struct node *child_split;
+	struct node *spare = NULL;
+
+	/* Allocate node for split in advance to do not fail after changing. */
+	if (TREE_NODE_CAP == node->cnt) {
+		spare = node_alloc(node->is_leaf);
+		if (NULL == spare)
+			return -1;
+	}
+
+	if (node->is_leaf) {
+		/* Make space for the item and insert it. */
+		node_shift_children(node, idx);
+		node->children[idx] = item;
+		node->lens[idx] = 1;
+		node->weights[idx] = weight;
+	} else {
+		/* Find child. Index after the last item goes to the last child. */
+		for (i = 0; i + 1 < node->cnt && idx > node->lens[i]; i++)
+			idx -= node->lens[i];
+		child = node->children[i];
+
+		/* Insert to the child. */
+		ret = node_ins(child, idx, item, weight, &child_split);
+		if (-1 == ret) {
+			free(spare);
+			return -1;
+		}
+
+		/* Insert split part of the child after it. */
+		if (NULL != child_split) {
+			node_shift_children(node, i + 1);
+			node->children[i + 1] = child_split;
+			node_sum(child_split, &node->lens[i + 1], &node->weights[i + 1]);
+		}
+		node_sum(child, &node->lens[i], &node->weights[i]);
+	}
+
+	/* Split overflowed node. Spare node is useless if there is no overflow. */
+	*split = NULL;
+	if (node->cnt > TREE_NODE_CAP) {
+		node_split(node, spare);
+		*split = spare;
+	} else {
+		free(spare);
+	}
+	return 0;
+}
+
+static void
+node_merge(struct node *const node, const size_t i)
+{
+	size_t j;
+	size_t k;
+	struct node *left;
+	struct node *right;
+
+	/* Child is big enough or there is no neighbour. */
+	if (node->cnt < 2 || ((struct node *)node->children[i])->cnt >= TREE_NODE_MIN)
+		return;
+
+	/* Get the child and its neighbour in order. */
+	j = i > 0 ? i - 1 : i;
+	left = node->children[j];
+	right = node->children[j + 1];
+	if (left->cnt + right->cnt > TREE_NODE_CAP)
+		return;
+
+	/* Move children of the right node to the left one. */
+	for (k = 0; k < right->cnt; k++) {
+		left->children[left->cnt] = right->children[k];
+		left->lens[left->cnt] = right->lens[k];
+		left->weights[left->cnt] = right->weights[k];
+		left->cnt++;
+	}
+	node->lens[j] += node->lens[j + 1];
+	node->weights[j] += node->weights[j + 1];
+
+	/* Remove the right node. */
+	right->cnt = 0;
+	node_free(right);
+	node_rm_child(node, j + 1);
+}
+
+static size_t
+node_rm(struct node *const node, size_t idx)
+{
+	size_t i;
+	size_t weight;
+	struct node *child;
+
+	/* Remove item from the leaf. */
+	if (node->is_leaf) {
+		weight = node->weights[idx];
+		node_rm_child(node, idx);
+		return weight;
+	}
+
+	/* Find child. */
+	for (i = 0; idx >= node->lens[i]; i++)
+		idx -= node->lens[i];
+	child = node->children[i];
+
+	/* Remove item from the child. */
+	weight = node_rm(child, idx);
+	node->lens[i]--;
+	node->weights[i] -= weight;
+
+	/* Remove empty child or merge small child with its neighbour. */
+	if (0 == child->cnt) {
+		node_free(child);
+		node_rm_child(node, i);
+	} else {
+		node_merge(node, i);
+	}
+	return weight;
+}
+
+static void
+node_rm_child(struct node *const node, const size_t idx)
+{
+	const size_t cnt = node->cnt - idx - 1;
+
+	memmove(&node->children[idx], &node->children[idx + 1],
+		cnt * sizeof(node->children[0]));
+	memmove(&node->lens[idx], &node->lens[idx + 1], cnt * sizeof(node->lens[0]));
+	memmove(&node->weights[idx], &node->weights[idx + 1],
+		cnt * sizeof(node->weights[0]));
+	node->cnt--;
+}
+
+static size_t
+node_set_weight(struct node *const node, size_t idx, const size_t weight)
+{
+	size_t i;
+	size_t prev;
+
+	/* Set weight of the item. */
+	if (node->is_leaf) {
+		prev = node->weights[idx];
+		node->weights[idx] = weight;
+		return prev;
+	}
+
+	/* Find child and update its weight. Unsigned overflow is fine here. */
+	for (i = 0; idx >= node->lens[i]; i++)
+		idx -= node->lens[i];
+	prev = node_set_weight(node->children[i], idx, weight);
+	node->weights[i] = node->weights[i] - prev + weight;
+	return prev;
+}
+
+static void
+node_shift_children(struct node *const node, const size_t idx)
+{
+	const size_t cnt = node->cnt - idx;
+
+	memmove(&node->children[idx + 1], &node->children[idx],
+		cnt * sizeof(node->children[0]));
+	memmove(&node->lens[idx + 1], &node->lens[idx], cnt * sizeof(node->lens[0]));
+	memmove(&node->weights[idx + 1], &node->weights[idx],
+		cnt * sizeof(node->weights[0]));
+	node->cnt++;
+}
+
+static void
+node_split(struct node *const node, struct node *const new)
+{
+	const size_t half = node->cnt / 2;
+
+	/* Copy the second half to the new node. */
+	new->cnt = node->cnt - half;
+	memcpy(new->children, &node->children[half],
+		new->cnt * sizeof(node->children[0]));
+	memcpy(new->lens, &node->lens[half], new->cnt * sizeof(node->lens[0]));
+	memcpy(new->weights, &node->weights[half],
+		new->cnt * sizeof(node->weights[0]));
+	node->cnt = half;
+}
+
+static void
+node_sum(const struct node *const node, size_t *const len, size_t *const weight)
+{
+	size_t i;
+
+	*len = 0;
+	*weight = 0;
+	for (i = 0; i < node->cnt; i++) {
+		*len += node->lens[i];
+		*weight += node->weights[i];
+	}
+}
+
+struct tree*
+tree_alloc(void)
+{
+	struct tree *tree;
+
+	/* Allocate opaque struct. */
+	tree = malloc(sizeof(*tree));
+	if (NULL == tree)
+		return NULL;
+
+	/* Allocate empty root. */
+	tree->root = node_alloc(1);
+	if (NULL == tree->root) {
+		free(tree);
+		return NULL;
+	}
+
+	tree->len = 0;
+	tree->weight = 0;
+	return tree;
+}
+
+void*
+tree_find(
+	const struct tree *const tree,
+	size_t pos,
+	size_t *const idx,
+	size_t *const first)
+{
+	size_t i;
+	const struct node *node = tree->root;
+
+	/* Validate position. */
+	if (pos >= tree->weight) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	*idx = 0;
+	*first = 0;
+	while (1) {
+		/* Skip children before the position. */
+		for (i = 0; pos >= node->weights[i]; i++) {
+			pos -= node->weights[i];
+			*idx += node->lens[i];
+			*first += node->weights[i];
+		}
+
+		if (node->is_leaf)
+			return node->children[i];
+		node = node->children[i];
+	}
+}
+
+void
+tree_free(struct tree *const tree)
+{
+	node_free(tree->root);
+	free(tree);
+}
+
+void*
+tree_get(const struct tree *const tree, size_t idx)
+{
+	size_t i;
+	const struct node *node = tree->root;
+
+	/* Validate index. */
+	if (idx >= tree->len) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	while (1) {
+		/* Skip children before the index. */
+		for (i = 0; idx >= node->lens[i]; i++)
+			idx -= node->lens[i];
+
+		if (node->is_leaf)
+			return node->children[i];
+		node = node->children[i];
+	}
+}
+
+int
+tree_ins(
+	struct tree *const tree,
+	const size_t idx,
+	void *const item,
+	const size_t weight)
+{
+	int ret;
+	struct node *split;
+	struct node *root = NULL;
+
+	/* Validate index. */
+	if (idx > tree->len) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Allocate new root in advance if the root may split. */
+	if (TREE_NODE_CAP == tree->root->cnt) {
+		root = node_alloc(0);
+		if (NULL == root)
+			return -1;
+	}
+
+	/* Insert item. */
+	ret = node_ins(tree->root, idx, item, weight, &split);
+	if (-1 == ret) {
+		free(root);
+		return -1;
+	}
+
+	/* Grow the tree if the root is split. */
+	if (NULL != split) {
+		root->children[0] = tree->root;
+		root->children[1] = split;
+		node_sum(tree->root, &root->lens[0], &root->weights[0]);
+		node_sum(split, &root->lens[1], &root->weights[1]);
+		root->cnt = 2;
+		tree->root = root;
+	} else {
+		free(root);
+	}
+
+	tree->len++;
+	tree->weight += weight;
+	return 0;
+}
+
+size_t
+tree_len(const struct tree *const tree)
+{
+	return tree->len;
+}
+
+int
+tree_rm(struct tree *const tree, const size_t idx)
+{
+	struct node *root;
+
+	/* Validate index. */
+	if (idx >= tree->len) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Remove item. */
+	tree->weight -= node_rm(tree->root, idx);
+	tree->len--;
+
+	root = tree->root;
+	if (!root->is_leaf && 0 == root->cnt) {
+		/* Empty root is a leaf. */
+		root->is_leaf = 1;
+	} else if (!root->is_leaf && 1 == root->cnt) {
+		/* Shrink the tree if the root has one child node. */
+		tree->root = root->children[0];
+		free(root);
+	}
+	return 0;
+}
+
+int
+tree_set_weight(struct tree *const tree, const size_t idx, const size_t weight)
+{
+	/* Validate index. */
+	if (idx >= tree->len) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Unsigned overflow is fine here. */
+	tree->weight = tree->weight - node_set_weight(tree->root, idx, weight) + weight;
+	return 0;
+}
+
+size_t
+tree_weight(const struct tree *const tree)
+{
+	return tree->weight;
+}
@@ -0,0 +1,82 @@
+#ifndef _TREE_H
+#define _TREE_H
+
+#include <stddef.h>
+
+/*
+ * Opaque counted B+ tree. Stores pointers to items in order. Every item has a
+ * weight, for example, count of lines. Items are found by index or by weighted
+ * position in logarithmic time.
+ */
+struct tree;
+
+/*
+ * Allocates empty tree. Do not forget to free it.
+ *
+ * Returns pointer to opaque tree on success and `NULL` on error.
+ */
+struct tree *tree_alloc(void);
+
+/*
+ * Finds item, which contains passed weighted position. Items with zero weight
+ * are skipped. Writes index of found item and weighted position of its
+ * beginning to passed pointers.
+ *
+ * Returns pointer to item on success and `NULL` on error.
+ *
+ * Sets `EINVAL` if position is not less than total weight.
+ */
+void *tree_find(const struct tree *, size_t, size_t *, size_t *);
+
+/*
+ * Frees allocated tree. Items are not freed.
+ */
+void tree_free(struct tree *);
+
+/*
+ * Gets item by index.
+ *
+ * Returns pointer to item on success and `NULL` on error.
+ *
+ * Sets `EINVAL` if index is invalid.
+ */
+void *tree_get(const struct tree *, size_t);
+
+/*
+ * Inserts item with passed weight by passed index.
+ *
+ * Returns 0 on success and -1 on error.
+ *
+ * Sets `EINVAL` if index is invalid.
+ */
+int tree_ins(struct tree *, size_t, void *, size_t);
+
+/*
+ * Returns count of items.
+ */
+size_t tree_len(const struct tree *);
+
+/*
+ * Removes item by index.
+ *
+ * Returns 0 on success and -1 on error.
+ *
+ * Sets `EINVAL` if index is invalid.
+ */
+int tree_rm(struct tree *, size_t);
+
+/*
+ * Sets weight of item by index.
+ *
+ * Returns 0 on success and -1 on error.
+ *
+ * Sets `EINVAL` if index is invalid.
+ */
+int tree_set_weight(struct tree *, size_t, size_t);
+
+/*
+ * Returns total weight of items.
+ */
+size_t tree_weight(const struct tree *);
+
+#endif /* _TREE_H */
@@ -0,0 +1,185 @@
+#ifndef _TVEC_H
+#define _TVEC_H
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "math.h"
+
+enum {
+	TVEC_CAP_STEP = 16, /* Min step of growing and shrinking of typed vector. */
+	TVEC_GROW_DIV = 2, /* Typed vector grows by half of its capacity. */
+	TVEC_SHRINK_DIV = 4, /* It shrinks if less than quarter is used. */
+};
+
+/*
+ * Checks condition of unchecked access if `TVEC_CHECK` is defined. Define it
+ * in debug builds to abort on access out of bounds.
+ */
+#ifdef TVEC_CHECK
+#define TVEC_ASSERT(cond) ((cond) ? (void)0 : abort())
+#else
+#define TVEC_ASSERT(cond) ((void)0)
+#endif
+
+/*
+ * Defines typed vector `struct name` of items with passed type and inline
+ * functions with `name_` prefix to work with it. Unlike `struct vec`, size of
+ * item is known at compile time and items are accessed without casts. Zeroed
+ * struct is an empty vector. Capacity grows geometrically and shrinks only if
+ * less than quarter of it is used.
+ *
+ * - `name_append` copies items to the end. Returns 0 or -1 on error.
+ * - `name_at` gets item by index without checking in release build.
+ * - `name_free` frees items and makes the vector empty.
+ * - `name_grow` grows capacity geometrically to fit passed length. Returns 0
+ *   or -1 on error.
+ * - `name_get` gets item by index. Returns `NULL` and sets `EINVAL` if index
+ *   is invalid.
+ * - `name_init` initializes empty vector.
+ * - `name_ins` copies items by index. Returns 0 or -1 on error and sets
+ *   `EINVAL` if index is invalid.
+ * - `name_reserve` grows capacity to passed count of items if it is less.
+ *   Returns 0 or -1 on error.
+ * - `name_rm` removes item by index and writes it to passed pointer if it is
+ *   not `NULL`. Returns 0 or -1 and sets `EINVAL` if index is invalid.
+ * - `name_shrink` shrinks capacity if too much space is unused. Vector stays
+ *   correct if reallocation fails, so there is no error.
+ */
+#define TVEC_DEF(name, type) \
+struct name { \
+	type *items; /* Dynamic array of items. */ \
+	size_t len; /* Length of dynamic array. */ \
+	size_t cap; /* Capacity of dynamic array. */ \
+}; \
+\
+static inline int \
+name##_reserve(struct name *const vec, const size_t cap) \
+{ \
+	type *items; \
+\
+	if (cap <= vec->cap) \
+		return 0; \
+	items = realloc(vec->items, cap * sizeof(type)); \
+	if (NULL == items) \
+		return -1; \
+	vec->items = items; \
+	vec->cap = cap; \
+	return 0; \
+} \
+\
+static inline int \
+name##_grow(struct name *const vec, const size_t len) \
+{ \
+	/* Grow by the part of capacity, but not less than the step. */ \
+	if (len <= vec->cap) \
+		return 0; \
+	return name##_reserve(vec, MAX( \
+		vec->cap + MAX((size_t)TVEC_CAP_STEP, vec->cap / TVEC_GROW_DIV), \
+		len)); \
+} \
+\
+static inline int \
+name##_append(struct name *const vec, const type *const items, const size_t len) \
+{ \
+	if (-1 == name##_grow(vec, vec->len + len)) \
+		return -1; \
+	memcpy(&vec->items[vec->len], items, len * sizeof(type)); \
+	vec->len += len; \
+	return 0; \
+} \
+\
+static inline type* \
+name##_at(const struct name *const vec, const size_t idx) \
+{ \
+	TVEC_ASSERT(idx < vec->len); \
+	return &vec->items[idx]; \
+} \
+\
+static inline void \
+name##_free(struct name *const vec) \
+{ \
+	free(vec->items); \
+	vec->items = NULL; \
+	vec->len = 0; \
+	vec->cap = 0; \
+} \
+\
+static inline type* \
+name##_get(const struct name *const vec, const size_t idx) \
+{ \
+	if (idx >= vec->len) { \
+		errno = EINVAL; \
+		return NULL; \
+	} \
+	return &vec->items[idx]; \
+} \
+\
+static inline void \
+name##_init(struct name *const vec) \
+{ \
+	vec->items = NULL; \
+	vec->len = 0; \
+	vec->cap = 0; \
+} \
+\
+static inline int \
+name##_ins( \
+	struct name *const vec, \
+	const size_t idx, \
+	const type *const items, \
+	const size_t len) \
+{ \
+	if (idx > vec->len) { \
+		errno = EINVAL; \
+		return -1; \
+	} \
+	if (-1 == name##_grow(vec, vec->len + len)) \
+		return -1; \
+	memmove(&vec->items[idx + len], &vec->items[idx], \
+		(vec->len - idx) * sizeof(type)); \
+	memcpy(&vec->items[idx], items, len * sizeof(type)); \
+	vec->len += len; \
+	return 0; \
+} \
+\
+static inline void \
+name##_shrink(struct name *const vec) \
+{ \
+	size_t cap; \
+	type *items; \
+\
+	/* Free items if vector is empty. */ \
+	if (0 == vec->len) { \
+		name##_free(vec); \
+		return; \
+	} \
+\
+	/* Shrink only if less than the part of capacity is used. */ \
+	if (vec->len >= vec->cap / TVEC_SHRINK_DIV \
+		|| vec->len + TVEC_CAP_STEP >= vec->cap) \
+		return; \
+	cap = vec->len + MAX((size_t)TVEC_CAP_STEP, vec->len / TVEC_GROW_DIV); \
+	items = realloc(vec->items, cap * sizeof(type)); \
+	if (NULL == items) \
+		return; \
+	vec->items = items; \
+	vec->cap = cap; \
+} \
+\
+static inline int \
+name##_rm(struct name *const vec, const size_t idx, type *const item) \
+{ \
+	if (idx >= vec->len) { \
+		errno = EINVAL; \
+		return -1; \
+	} \
+	if (NULL != item) \
+		*item = vec->items[idx]; \
+	memmove(&vec->items[idx], &vec->items[idx + 1], \
+		(--vec->len - idx) * sizeof(type)); \
+	name##_shrink(vec); \
+	return 0; \
+}
+
+#endif /* _TVEC_H */
@@ -8,14 +8,16 @@
 #include "vec.h"
 
 /*
- * Dynamic vector with capacity reallocation step.
+ * Dynamic vector. Capacity grows geometrically, so appending is amortized
+ * constant. Capacity shrinks only if most of it is unused, so removing after
+ * appending does not reallocate every time.
  */
 struct vec {
 	char *items; /* Pointer to the beginning of dynamic array with items . */
 	size_t item_size; /* Size of item in dynamic array. */
 	size_t len; /* Length of dynamic array. */
 	size_t cap; /* Capacity of dynamic array. */
-	size_t cap_step; /* Step of growing and shrinking of dynamic array. */
+	struct vec_policy policy; /* Policy of capacity changes. */
 };
 
 /*
@@ -42,7 +44,7 @@ static int vec_realloc(struct vec *, size_t);
 static int vec_ins_fmt_va(struct vec *, size_t, const char *, va_list);
 
 struct vec*
-vec_alloc(const size_t item_size, const size_t cap_step)
+vec_alloc(const size_t item_size, const struct vec_policy *const policy)
 {
 	struct vec *vec;
 
@@ -53,7 +55,7 @@ vec_alloc(const size_t item_size, const size_t cap_step)
 
 	/* Initialize the vector. */
 	vec->item_size = item_size;
-	vec->cap_step = cap_step;
+	vec->policy = *policy;
 	return vec;
 }
 
@@ -107,8 +109,10 @@ vec_grow_if_needed(struct vec *const vec, const size_t new_len)
 	if (new_len <= vec->cap)
 		return 0;
 
-	/* Get optimal new capacity. */
-	new_cap = MAX(vec->cap + vec->cap_step, new_len);
+	/* Grow by the part of capacity, but not less than the step. */
+	new_cap = MAX(
+		vec->cap + MAX(vec->policy.cap_step, vec->cap / vec->policy.grow_div),
+		new_len);
 
 	/* Grow with new capacity. */
 	ret = vec_realloc(vec, new_cap);
@@ -210,10 +214,30 @@ vec_len(const struct vec *const vec)
 static int
 vec_realloc(struct vec *const vec, const size_t new_cap)
 {
-	/* Reallocate items and update the capacity. */
+	char *items;
+
+	/* Reallocate items. Vector is not changed on error. */
+	items = realloc(vec->items, new_cap * vec->item_size);
+	if (NULL == items)
+		return -1;
+
+	/* Update items and the capacity. */
+	vec->items = items;
 	vec->cap = new_cap;
-	vec->items = realloc(vec->items, new_cap * vec->item_size);
-	return NULL == vec->items ? -1 : 0;
+	return 0;
+}
+
+int
+vec_reserve(struct vec *const vec, const size_t cap)
+{
+	int ret;
+
+	/* Capacity is already enough. */
+	if (cap <= vec->cap)
+		return 0;
+
+	ret = vec_realloc(vec, cap);
+	return ret;
 }
 
 int
@@ -280,10 +304,14 @@ vec_shrink_if_needed(struct vec *const vec)
 		return 0;
 	}
 
-	/* Check there is not enough unused space to shrink. */
-	if (vec->len + vec->cap_step > vec->cap)
+	/* Shrink only if less than the part of capacity is used. */
+	if (vec->len >= vec->cap / vec->policy.shrink_div
+		|| vec->len + vec->policy.cap_step >= vec->cap)
 		return 0;
 
-	ret = vec_realloc(vec, vec->len);
+	/* Leave space to do not grow right after shrinking. */
+	ret = vec_realloc(
+		vec,
+		vec->len + MAX(vec->policy.cap_step, vec->len / vec->policy.grow_div));
 	return ret;
 }
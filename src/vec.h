@@ -3,15 +3,32 @@
 
 #include <stddef.h>
 
+enum {
+	VEC_GROW_DIV = 2, /* Default growing by half of capacity. */
+	VEC_SHRINK_DIV = 4, /* Default shrinking if less than quarter is used. */
+};
+
 /* Opaque vector structure. */
 struct vec;
 
 /*
- * Allocates new vector. Do not forget to free it.
+ * Policy of capacity changes. Capacity grows by its part, but not less than
+ * the step. Capacity shrinks if less than its part is used, and the space for
+ * growing is left, so the vector does not grow right after shrinking.
+ */
+struct vec_policy {
+	size_t cap_step; /* Min step of growing and shrinking. */
+	size_t grow_div; /* Capacity grows by its part. Not 0. */
+	size_t shrink_div; /* Shrinks if less than its part is used. Not 0. */
+};
+
+/*
+ * Allocates new vector, which changes its capacity using passed policy. Do
+ * not forget to free it.
  *
  * Returns pointer to opaque vector on success and `NULL` on error.
  */
-struct vec *vec_alloc(size_t, size_t);
+struct vec *vec_alloc(size_t, const struct vec_policy *);
 
 /*
  * Copies items to the end of vector. Grows capacity if there is not enough
@@ -80,6 +97,14 @@ int vec_ins_fmt(struct vec *, size_t, const char *, ...);
  */
 size_t vec_len(const struct vec *);
 
+/*
+ * Grows capacity to passed count of items if it is less. Use it to avoid
+ * reallocations if count of items is known in advance.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int vec_reserve(struct vec *, size_t);
+
 /*
  * Finds and removes item by its index. Shrinks capacity if too much space is
  * unused.
@@ -105,7 +130,7 @@ int vec_rm(struct vec *, size_t, void *);
 int vec_set_len(struct vec *, size_t);
 
 /*
- * Shrinks capacity if too much space is unused.
+ * Shrinks capacity if less than the policy's part of it is used.
  *
  * Returns 0 on success and -1 on error.
  */
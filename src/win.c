@@ -2,18 +2,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include "buf.h"
 #include "cfg.h"
 #include "esc.h"
 #include "file.h"
 #include "math.h"
-#include "str.h"
+#include "renders.h"
+#include "scr.h"
 #include "term.h"
-#include "vec.h"
 #include "win.h"
 #include "word.h"
 
 enum {
 	STAT_ROWS_CNT = 1, /* Count of rows reserved for status. */
+	RENDERS_PER_ROW = 2, /* Count of cached renders per row of the window. */
 };
 
 /*
@@ -42,21 +44,17 @@ struct win {
 	struct offset offset; /* offset of view/file. Tab's width is 1. */
 	struct cur cur; /* Pointer to the viewed char. Tab's width is 1. */
 	struct winsize size; /* Terminal window size. */
+	struct renders *renders; /* Renders of recently drawn lines. */
+	size_t drawn_offset_rows; /* Rows offset of the last drawn frame. */
 };
 
 /*
- * Draws row on the window if exists or special config string.
+ * Draws row on the window if exists or special config string. Visible part of
+ * the line's render is referenced by the row without copying.
  *
  * Returns 0 on success and -1 on error.
  */
-static int win_draw_line(const struct win *, struct vec *, unsigned short);
-
-/*
- * Gets the count of characters by which the part of line is expanded using
- * tabs. The part of the line from the beginning to the passed column is
- * considered.
- */
-static size_t win_exp_col(const struct pub_line *, size_t);
+static int win_draw_line(struct win *, struct scr_row *, unsigned short);
 
 /*
  * Collection of methods to scroll and fix cursor.
@@ -82,6 +80,13 @@ static void win_scroll_overflowed_cur(struct win *);
  */
 static int win_scroll_to_line(struct win *);
 
+/*
+ * Waits until passed count of lines below the current one is loaded.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+static int win_wait_lines_below(struct win *, size_t);
+
 int
 win_close(struct win *const win)
 {
@@ -94,6 +99,8 @@ win_close(struct win *const win)
 
 	/* Close opened file. */
 	file_close(win->file);
+	/* Free renders of lines. */
+	renders_free(win->renders);
 	/* Free opaque struct. */
 	free(win);
 	return 0;
@@ -179,6 +186,9 @@ win_del_line(struct win *const win, size_t times)
 		return 0;
 
 	/* Get real repeat times. */
+	ret = win_wait_lines_below(win, times - 1);
+	if (-1 == ret)
+		return -1;
 	times = MIN(times, file_lines_cnt(win->file) - win_curr_line_idx(win));
 
 	/* Remove column offsets. */
@@ -201,7 +211,7 @@ win_del_line(struct win *const win, size_t times)
 }
 
 int
-win_draw_cur(const struct win *const win, struct vec *const buf)
+win_draw_cur(struct win *const win, struct buf *const buf)
 {
 	int ret;
 	struct pub_line line;
@@ -214,8 +224,13 @@ win_draw_cur(const struct win *const win, struct vec *const buf)
 		return -1;
 
 	/* Expand offset and file columns. */
-	exp_offset_col = win_exp_col(&line, win->offset.cols);
-	exp_col = win_exp_col(&line, win->offset.cols + win->cur.col);
+	ret = renders_col(win->renders, &line, win->offset.cols, &exp_offset_col);
+	if (-1 == ret)
+		return -1;
+	ret = renders_col(win->renders, &line, win->offset.cols + win->cur.col,
+		&exp_col);
+	if (-1 == ret)
+		return -1;
 
 	/* Sub expanded columns to get real column in the window and set cursor. */
 	esc_cur_set(buf, win->cur.row, exp_col - exp_offset_col);
@@ -224,10 +239,12 @@ win_draw_cur(const struct win *const win, struct vec *const buf)
 
 static int
 win_draw_line(
-	const struct win *const win, struct vec *const buf, const unsigned short row)
+	struct win *const win, struct scr_row *const dst, const unsigned short row)
 {
 	int ret;
 	struct pub_line line;
+	const char *render;
+	size_t render_len;
 	size_t exp_offset_col;
 	size_t len_to_draw;
 	size_t lines_cnt;
@@ -237,7 +254,7 @@ win_draw_line(
 
 	/* Checking if there is a line to draw at this row. */
 	if (win->offset.rows + row >= lines_cnt) {
-		ret = vec_append(buf, &cfg_no_line, 1);
+		ret = buf_append(&dst->chars, &cfg_no_line, 1);
 		return ret;
 	}
 
@@ -246,63 +263,74 @@ win_draw_line(
 	if (-1 == ret)
 		return -1;
 
+	/* Get cached render or render the line. */
+	ret = renders_get(win->renders, &line, &render, &render_len);
+	if (-1 == ret)
+		return -1;
+
 	/* Get expanded with tabs offset's column. */
-	exp_offset_col = win_exp_col(&line, win->offset.cols);
+	ret = renders_col(win->renders, &line, win->offset.cols, &exp_offset_col);
+	if (-1 == ret)
+		return -1;
 	/* Do nothing if line hidden behind offset or empty. */
-	if (line.render_len <= exp_offset_col)
+	if (render_len <= exp_offset_col)
 		return 0;
 
 	/* Calculate length to draw using expanded length and draw. */
-	len_to_draw = MIN(win->size.ws_col, line.render_len - exp_offset_col);
-	ret = vec_append(buf, &line.render[exp_offset_col], len_to_draw);
-	return ret;
+	len_to_draw = MIN(win->size.ws_col, render_len - exp_offset_col);
+	dst->ref = &render[exp_offset_col];
+	dst->ref_len = len_to_draw;
+	return 0;
 }
 
 int
-win_draw_lines(const struct win *const win, struct vec *const buf)
+win_draw_lines(struct win *const win, struct scr *const scr)
 {
 	int ret;
 	unsigned short row;
-
-	/* Set colors. */
-	ret = esc_color_fg(buf, cfg_color_lines_fg);
-	if (-1 == ret)
-		return -1;
-
-	for (row = 0; row + STAT_ROWS_CNT < win->size.ws_row; row++) {
-		/* Draw line. */
-		ret = win_draw_line(win, buf, row);
+	struct scr_row *dst;
+	const unsigned short rows = win->size.ws_row > STAT_ROWS_CNT
+		? win->size.ws_row - STAT_ROWS_CNT : 0;
+	const size_t drawn = win->drawn_offset_rows;
+
+	/* Scroll rows, which are still visible after offset change. */
+	if (win->offset.rows > drawn && win->offset.rows - drawn < rows)
+		scr_scroll(scr, 0, rows, win->offset.rows - drawn);
+	else if (win->offset.rows < drawn && drawn - win->offset.rows < rows)
+		scr_scroll(scr, 0, rows, -(int)(drawn - win->offset.rows));
+	win->drawn_offset_rows = win->offset.rows;
+
+	for (row = 0; row < rows; row++) {
+		/* Set colors. */
+		dst = scr_row(scr, row);
+		ret = esc_color_fg(&dst->attrs, &cfg_color_lines_fg);
 		if (-1 == ret)
 			return -1;
 
-		/* Move to the beginning of the next row. */
-		ret = vec_append(buf, "\r\n", 2);
+		/* Draw line. */
+		ret = win_draw_line(win, dst, row);
 		if (-1 == ret)
 			return -1;
 	}
-
-	/* End colored output. */
-	ret = esc_color_end(buf);
-	return ret;
+	return 0;
 }
 
-static size_t
-win_exp_col(const struct pub_line *const line, const size_t col)
+char
+win_file_is_dirty(const struct win *const win)
 {
-	size_t i;
-	size_t exp = 0;
-	const size_t end = MIN(col, line->len);
-
-	/* Iterate over every character in the selected area. */
-	for (i = 0; i < end; i++)
-		exp += str_exp(line->chars[i], exp);
-	return exp;
+	return file_is_dirty(win->file);
 }
 
 char
-win_file_is_dirty(const struct win *const win)
+win_file_is_loading(const struct win *const win)
 {
-	return file_is_dirty(win->file);
+	return file_is_loading(win->file);
+}
+
+size_t
+win_file_load_pct(const struct win *const win)
+{
+	return file_load_pct(win->file);
 }
 
 const char*
@@ -380,6 +408,52 @@ win_ins_empty_line_on_top(struct win *const win, size_t times)
 	return 0;
 }
 
+int
+win_ins_str(struct win *const win, const char *const chars, const size_t len)
+{
+	int ret;
+	const char *end;
+	size_t breaks_cnt = 0;
+	size_t col = win_curr_line_char_idx(win);
+	const char *begin = chars;
+
+	/* Insert characters with all their lines at once. */
+	ret = file_ins_str(
+		win->file,
+		win_curr_line_idx(win),
+		win_curr_line_char_idx(win),
+		chars,
+		len
+	);
+	if (-1 == ret)
+		return -1;
+
+	/* Count line breaks to find where the inserted characters end. */
+	while (NULL != (end = memchr(begin, '\n', &chars[len] - begin))) {
+		breaks_cnt++;
+		begin = end + 1;
+	}
+
+	/* Move to the beginning of the last inserted line. */
+	if (breaks_cnt > 0) {
+		win_mv_to_begin_of_line(win);
+		ret = win_mv_down(win, breaks_cnt);
+		if (-1 == ret)
+			return -1;
+		col = 0;
+	}
+
+	/* Move right after the last inserted character. */
+	col += &chars[len] - begin;
+	if (col - win->offset.cols >= win->size.ws_col)
+		win->offset.cols = col - win->size.ws_col + 1;
+	win->cur.col = col - win->offset.cols;
+
+	/* Fix expanded cursor column. */
+	ret = win_scroll(win);
+	return ret;
+}
+
 int
 win_mv_down(struct win *const win, size_t times)
 {
@@ -388,6 +462,11 @@ win_mv_down(struct win *const win, size_t times)
 	if (0 == times)
 		return 0;
 
+	/* Wait lines, which are needed to move. */
+	ret = win_wait_lines_below(win, times);
+	if (-1 == ret)
+		return -1;
+
 	while (times-- > 0) {
 		/* Return if there is no more space to move down. */
 		if (win->offset.rows + win->cur.row + 1 >= file_lines_cnt(win->file))
@@ -455,6 +534,9 @@ win_mv_right(struct win *const win, size_t times)
 	while (times-- > 0) {
 		if (win_curr_line_char_idx(win) >= line.len) {
 			/* Check there is no next line. */
+			ret = win_wait_lines_below(win, 1);
+			if (-1 == ret)
+				return -1;
 			if (win_curr_line_idx(win) + 1 == file_lines_cnt(win->file))
 				break;
 
@@ -499,12 +581,16 @@ win_mv_to_begin_of_line(struct win *const win)
 	win->cur.col = 0;
 }
 
-void
+int
 win_mv_to_end_of_file(struct win *const win)
 {
+	int ret;
 	size_t lines_cnt;
 
-	/* Get lines count. */
+	/* Get lines count of the whole file. */
+	ret = file_wait_lines(win->file, SIZE_MAX);
+	if (-1 == ret)
+		return -1;
 	lines_cnt = file_lines_cnt(win->file);
 
 	/* Move to begin of last line. */
@@ -518,6 +604,7 @@ win_mv_to_end_of_file(struct win *const win)
 		win->offset.rows = lines_cnt - (win->size.ws_row - STAT_ROWS_CNT);
 		win->cur.row = win->size.ws_row - STAT_ROWS_CNT - 1;
 	}
+	return 0;
 }
 
 int
@@ -525,17 +612,21 @@ win_mv_to_end_of_line(struct win *const win)
 {
 	int ret;
 	struct pub_line line;
+	size_t exp_len;
 
-	/* Get line. */
+	/* Get line and its length with expanded tabs. */
 	ret = file_line(win->file, win_curr_line_idx(win), &line);
+	if (-1 == ret)
+		return -1;
+	ret = renders_col(win->renders, &line, line.len, &exp_len);
 	if (-1 == ret)
 		return -1;
 
 	/* Check that end of line in the current window. */
-	if (line.render_len < win->offset.cols + win->size.ws_col) {
-		win->cur.col = line.render_len - win->offset.cols;
+	if (exp_len < win->offset.cols + win->size.ws_col) {
+		win->cur.col = exp_len - win->offset.cols;
 	} else {
-		win->offset.cols = line.render_len - win->size.ws_col + 1;
+		win->offset.cols = exp_len - win->size.ws_col + 1;
 		win->cur.col = win->size.ws_col - 1;
 	}
 
@@ -552,8 +643,8 @@ win_mv_to_next_word(struct win *const win, size_t times)
 	size_t word_idx;
 	struct pub_line line;
 
-	/* Get line. */
-	ret = file_line(win->file, win_curr_line_idx(win), &line);
+	/* Get line with contiguous characters to find words. */
+	ret = file_line_flat(win->file, win_curr_line_idx(win), &line);
 	if (-1 == ret)
 		return -1;
 
@@ -590,8 +681,8 @@ win_mv_to_prev_word(struct win *const win, size_t times)
 	if (0 == times)
 		return 0;
 
-	/* Get line. */
-	ret = file_line(win->file, win_curr_line_idx(win), &line);
+	/* Get line with contiguous characters to find words. */
+	ret = file_line_flat(win->file, win_curr_line_idx(win), &line);
 	if (-1 == ret)
 		return -1;
 
@@ -643,7 +734,11 @@ win_mv_up(struct win *const win, size_t times)
 }
 
 struct win*
-win_open(const char *const path, const int ifd, const int ofd)
+win_open(
+	const char *const path,
+	const int ifd,
+	const int ofd,
+	const size_t threads_cnt)
 {
 	int ret;
 	struct win *win;
@@ -654,13 +749,14 @@ win_open(const char *const path, const int ifd, const int ofd)
 		return NULL;
 
 	/* Open file. */
-	win->file = file_open(path);
+	win->file = file_open(path, threads_cnt);
 	if (NULL == win->file)
 		goto err_free_opaque;
 
 	/* Initialize offset and cursor. */
 	memset(&win->offset, 0, sizeof(win->offset));
 	memset(&win->cur, 0, sizeof(win->cur));
+	win->drawn_offset_rows = 0;
 
 	/* Initialize terminal with accepted descriptors. */
 	ret = term_init(ifd, ofd);
@@ -671,6 +767,11 @@ win_open(const char *const path, const int ifd, const int ofd)
 	ret = term_get_win_size(&win->size);
 	if (-1 == ret)
 		goto err_clean_all;
+
+	/* Allocate renders of lines, which fit the window. */
+	win->renders = renders_alloc((size_t)win->size.ws_row * RENDERS_PER_ROW);
+	if (NULL == win->renders)
+		goto err_clean_all;
 	return win;
 err_clean_all:
 	/* Errors checking here is useless. */
@@ -720,26 +821,32 @@ win_scroll_exp_col(struct win *const win)
 {
 	int ret;
 	struct pub_line line;
-	size_t exp_offset_col;
 	size_t exp_col;
+	size_t offset_col;
+	const size_t col = win_curr_line_char_idx(win);
 
 	/* Get current line. */
 	ret = file_line(win->file, win_curr_line_idx(win), &line);
 	if (-1 == ret)
 		return -1;
 
-	while (1) {
-		/* Get expanded hidden column and expanded viewed column. */
-		exp_col = win_exp_col(&line, win->offset.cols + win->cur.col);
-		exp_offset_col = win_exp_col(&line, win->offset.cols);
+	/* Get expanded viewed column. */
+	ret = renders_col(win->renders, &line, col, &exp_col);
+	if (-1 == ret)
+		return -1;
 
-		/* Check that diff between expansion is not greater than window's width. */
-		if (exp_col - exp_offset_col < win->size.ws_col)
-			break;
+	/* Diff between expansions must be less than window's width. */
+	if (exp_col < win->size.ws_col)
+		return 0;
+	ret = renders_idx(win->renders, &line, exp_col - win->size.ws_col + 1,
+		&offset_col);
+	if (-1 == ret)
+		return -1;
 
-		/* Shift to view pointed content. */
-		win->offset.cols++;
-		win->cur.col--;
+	/* Shift to view pointed content. */
+	if (offset_col > win->offset.cols) {
+		win->offset.cols = offset_col;
+		win->cur.col = col - offset_col;
 	}
 	return 0;
 }
@@ -782,7 +889,7 @@ win_scroll_to_line(struct win *const win)
 }
 
 int
-win_search_bwd(struct win *const win, const char *const query)
+win_search_bwd(struct win *const win, const struct search *const search)
 {
 	int ret;
 	size_t idx;
@@ -793,7 +900,7 @@ win_search_bwd(struct win *const win, const char *const query)
 	pos = win_curr_line_char_idx(win);
 
 	/* Search with accepted query. */
-	ret = file_search_bwd(win->file, &idx, &pos, query);
+	ret = file_search_bwd(win->file, &idx, &pos, search);
 	if (-1 == ret)
 		return -1;
 	if (0 == ret)
@@ -813,7 +920,7 @@ win_search_bwd(struct win *const win, const char *const query)
 }
 
 int
-win_search_fwd(struct win *const win, const char *const query)
+win_search_fwd(struct win *const win, const struct search *const search)
 {
 	int ret;
 	size_t idx;
@@ -824,14 +931,23 @@ win_search_fwd(struct win *const win, const char *const query)
 	if (-1 == ret)
 		return -1;
 
-	/* Prepare indexes. */
-	idx = win_curr_line_idx(win);
-	pos = win_curr_line_char_idx(win);
+	while (1) {
+		/* Prepare indexes. */
+		idx = win_curr_line_idx(win);
+		pos = win_curr_line_char_idx(win);
 
-	/* Search with accepted query. */
-	ret = file_search_fwd(win->file, &idx, &pos, query);
-	if (-1 == ret)
-		return -1;
+		/* Search with accepted query. */
+		ret = file_search_fwd(win->file, &idx, &pos, search);
+		if (-1 == ret)
+			return -1;
+		if (0 != ret || !file_is_loading(win->file))
+			break;
+
+		/* Result may be in lines, which are not loaded yet. */
+		ret = file_wait_lines(win->file, SIZE_MAX);
+		if (-1 == ret)
+			return -1;
+	}
 	if (0 == ret) {
 		/* Move back to start position if no results during forward searching. */
 		ret = win_mv_left(win, 1);
@@ -858,17 +974,45 @@ win_size(const struct win *const win)
 	return win->size;
 }
 
+int
+win_take_loaded_lines(struct win *const win)
+{
+	return file_wait_lines(win->file, 0);
+}
+
 int
 win_upd_size(struct win *const win)
 {
 	int ret;
+	struct renders *renders;
+	const unsigned short rows = win->size.ws_row;
 
 	/* Update size using terminal. */
 	ret = term_get_win_size(&win->size);
 	if (-1 == ret)
 		return -1;
 
+	/* Count of renders depends on count of rows. */
+	if (win->size.ws_row != rows) {
+		renders = renders_alloc((size_t)win->size.ws_row * RENDERS_PER_ROW);
+		if (NULL == renders)
+			return -1;
+		renders_free(win->renders);
+		win->renders = renders;
+	}
+
 	/* Scroll after resize. */
 	ret = win_scroll(win);
 	return ret;
 }
+
+static int
+win_wait_lines_below(struct win *const win, const size_t cnt)
+{
+	const size_t idx = win_curr_line_idx(win);
+
+	/* Wait the whole file if the count is too big. */
+	if (cnt >= SIZE_MAX - idx)
+		return file_wait_lines(win->file, SIZE_MAX);
+	return file_wait_lines(win->file, idx + cnt + 1);
+}
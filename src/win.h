@@ -3,7 +3,9 @@
 
 #include <stddef.h>
 #include <sys/ioctl.h>
-#include "vec.h"
+#include "buf.h"
+#include "scr.h"
+#include "search.h"
 
 /*
  * Opaque struct with window parameters.
@@ -50,18 +52,29 @@ int win_del_line(struct win *, size_t);
 /*
  * Draws cursor.
  */
-int win_draw_cur(const struct win *, struct vec *);
+int win_draw_cur(struct win *, struct buf *);
 
 /*
- * Draws window rows.
+ * Draws window rows to rows of the next frame of the screen. Rows refer to
+ * renders of lines, so flush the screen before the window is changed.
  */
-int win_draw_lines(const struct win *, struct vec *);
+int win_draw_lines(struct win *, struct scr *);
 
 /*
  * Checks that opened file is dirty.
  */
 char win_file_is_dirty(const struct win *);
 
+/*
+ * Checks that opened file is still loading.
+ */
+char win_file_is_loading(const struct win *);
+
+/*
+ * Returns percentage of loaded opened file.
+ */
+size_t win_file_load_pct(const struct win *);
+
 /*
  * Returns opened file's path.
  */
@@ -82,6 +95,11 @@ int win_ins_empty_line_below(struct win *, size_t);
  */
 int win_ins_empty_line_on_top(struct win *, size_t);
 
+/*
+ * Inserts characters to the file. Line breaks in them split the line.
+ */
+int win_ins_str(struct win *, const char *, size_t);
+
 /*
  * Move down several times.
  */
@@ -108,9 +126,11 @@ void win_mv_to_begin_of_file(struct win *);
 void win_mv_to_begin_of_line(struct win *);
 
 /*
- * Moves to begin of last line.
+ * Moves to begin of last line. Waits the whole file if it is still loading.
+ *
+ * Returns 0 on success and -1 on error.
  */
-void win_mv_to_end_of_file(struct win *);
+int win_mv_to_end_of_file(struct win *);
 
 /*
  * Moves to begin of current line.
@@ -134,8 +154,10 @@ int win_mv_up(struct win *, size_t);
 
 /*
  * Opens terminal window with file. Do not forget to close it.
+ *
+ * Passed count of threads is used for heavy file operations.
  */
-struct win *win_open(const char *, int, int);
+struct win *win_open(const char *, int, int, size_t);
 
 /*
  * Saves opened file. Returns saved bytes count.
@@ -153,20 +175,27 @@ size_t win_save_file_to_spare_dir(struct win *, char *, size_t);
  *
  * Returns 0 on success and -1 on error.
  */
-int win_search_bwd(struct win *, const char *);
+int win_search_bwd(struct win *, const struct search *);
 
 /*
  * Searches forward from current position to end of file using passed query.
  *
  * Returns 0 on success and -1 on error.
  */
-int win_search_fwd(struct win *, const char *);
+int win_search_fwd(struct win *, const struct search *);
 
 /*
  * Gets size of window.
  */
 struct winsize win_size(const struct win *);
 
+/*
+ * Takes lines of opened file, which were loaded since the last call.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+int win_take_loaded_lines(struct win *);
+
 /*
  * Updates size of opened window using terminal.
  */